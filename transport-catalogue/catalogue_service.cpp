@@ -0,0 +1,105 @@
+#include "catalogue_service.h"
+#include "serialization.h"
+
+#include <exception>
+#include <iostream>
+#include <utility>
+
+namespace tc{
+namespace service{
+
+StatePtr MakeState(TransportCatalogue tc, const renderer::RenderSettings& render_set,
+                   const router::RoutingSettings& routing_set, router::Landmarks landmarks, uint64_t version){
+    auto state = std::make_shared<ServiceState>();
+    state->version = version;
+    state->catalogue = std::move(tc).Freeze();
+    state->renderer = renderer::MapRenderer(render_set);
+    state->router = std::make_shared<const router::Router>(routing_set, state->catalogue, std::move(landmarks));
+    return state;
+}
+
+StatePtr LoadState(const std::string& filename, uint64_t version){
+    TransportCatalogue tc;
+    renderer::RenderSettings render_set;
+    router::RoutingSettings routing_set;
+    router::Landmarks landmarks;
+    if (!serialization::Deserialize(tc, render_set, routing_set, landmarks, filename)){
+        return nullptr;
+    }
+    return MakeState(std::move(tc), render_set, routing_set, std::move(landmarks), version);
+}
+
+StateHandle::StateHandle(StatePtr state)
+    : state_(std::move(state)){
+}
+
+StateHandle::~StateHandle(){
+    std::unique_lock lock(loader_mutex_);
+    pending_loads_.clear();
+    lock.unlock();
+    // The loader ends when it finds the queue empty
+    if (loader_.joinable()){
+        loader_.join();
+    }
+}
+
+StatePtr StateHandle::Acquire() const{
+    return std::atomic_load(&state_);
+}
+
+void StateHandle::Publish(StatePtr state){
+    std::atomic_store(&state_, std::move(state));
+}
+
+bool StateHandle::Reload(const std::string& filename){
+    std::lock_guard guard(reload_mutex_);
+    const StatePtr current = Acquire();
+    StatePtr state;
+    try {
+        state = LoadState(filename, current ? current->version + 1 : 0);
+    } catch (const std::exception& e) {
+        std::cerr << "Can not load base " << filename << ": " << e.what() << std::endl;
+        return false;
+    }
+    if (!state){
+        std::cerr << "Can not read base " << filename << std::endl;
+        return false;
+    }
+    Publish(std::move(state));
+    return true;
+}
+
+void StateHandle::ReloadAsync(std::string filename){
+    std::lock_guard guard(loader_mutex_);
+    pending_loads_.push_back(std::move(filename));
+    if (is_loading_){
+        return;
+    }
+    is_loading_ = true;
+    // The previous loader has found the queue empty, it only has to return
+    if (loader_.joinable()){
+        loader_.join();
+    }
+    loader_ = std::thread([this](){
+        LoadPending();
+    });
+}
+
+void StateHandle::LoadPending(){
+    while (true){
+        std::string filename;
+        {
+            std::lock_guard guard(loader_mutex_);
+            if (pending_loads_.empty()){
+                is_loading_ = false;
+                return;
+            }
+            filename = std::move(pending_loads_.front());
+            pending_loads_.pop_front();
+        }
+        Reload(filename);
+    }
+}
+
+} // namespace service
+} // namespace tc
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace tc{
+namespace service{
+
+// Everything stat requests are answered from, built from one base and never changed after that
+struct ServiceState{
+    uint64_t version = 0;
+    CatalogueSnapshot catalogue;
+    renderer::MapRenderer renderer;
+    std::shared_ptr<const router::Router> router;
+};
+
+using StatePtr = std::shared_ptr<const ServiceState>;
+
+StatePtr MakeState(TransportCatalogue tc, const renderer::RenderSettings& render_set,
+                   const router::RoutingSettings& routing_set, router::Landmarks landmarks, uint64_t version = 0);
+// Reads the base, returns nullptr if it can not be read
+StatePtr LoadState(const std::string& filename, uint64_t version = 0);
+
+// Current state of the service, replaced as a whole (RCU style).
+// A reader takes the state with Acquire and keeps it to the end of its request: a state published
+// meanwhile is seen only by later Acquire calls, and the old one is freed when its last reader drops it.
+// Readers never wait for a base being loaded, they only copy a shared pointer.
+class StateHandle{
+public:
+    explicit StateHandle(StatePtr state);
+    StateHandle(const StateHandle&) = delete;
+    StateHandle& operator=(const StateHandle&) = delete;
+    // Waits for the background load running now, the queued ones are dropped
+    ~StateHandle();
+
+    StatePtr Acquire() const;
+    void Publish(StatePtr state);
+
+    // Loads the base and publishes it with the next version number.
+    // Returns false and keeps the current state if the base can not be read.
+    bool Reload(const std::string& filename);
+    // The same in a background thread, returns at once. A base requested while another one
+    // is being loaded is queued, loads are published in call order.
+    void ReloadAsync(std::string filename);
+
+private:
+    // Accessed only through std::atomic_load and std::atomic_store
+    StatePtr state_;
+    // Serializes Reload calls, so version numbers grow
+    std::mutex reload_mutex_;
+
+    // Bases waiting for the loader thread, it runs while the queue is not empty
+    std::mutex loader_mutex_;
+    std::deque<std::string> pending_loads_;
+    bool is_loading_ = false;
+    std::thread loader_;
+
+    void LoadPending();
+};
+
+} // namespace service
+} // namespace tc
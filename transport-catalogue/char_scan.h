@@ -0,0 +1,47 @@
+#pragma once
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Search for the chars which have to be handled one by one (quotes, escapes), so that
+// the text between them is copied as a whole
+namespace char_scan {
+
+#if defined(__SSE2__)
+namespace detail {
+
+// Byte i of the result is 0xFF if byte i of the block is one of Chars
+template <char... Chars>
+inline __m128i MatchAnyOf(__m128i block) {
+    __m128i result = _mm_setzero_si128();
+    ((result = _mm_or_si128(result, _mm_cmpeq_epi8(block, _mm_set1_epi8(Chars)))), ...);
+    return result;
+}
+
+} // namespace detail
+#endif
+
+// First char of [first, last) which is one of Chars, last if there is none.
+// With SSE2 16 chars are checked at once, the rest char by char
+template <char... Chars>
+inline const char* FindAnyOf(const char* first, const char* last) {
+#if defined(__SSE2__)
+    while (last - first >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const int mask = _mm_movemask_epi8(detail::MatchAnyOf<Chars...>(block));
+        if (mask != 0) {
+            return first + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        first += 16;
+    }
+#endif
+    for (; first != last; ++first) {
+        if (((*first == Chars) || ...)) {
+            return first;
+        }
+    }
+    return last;
+}
+
+} // namespace char_scan
@@ -1,29 +1,95 @@
 #pragma once
 
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 
-#include "geo.h"
+#include "ranges.h"
 
 namespace tc {
 
-struct Stop{
-    bool operator==(const Stop& other) const {
-        return name == other.name;
+// Index of a stop or a bus in the order they were added to the catalogue
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// Stops of a bus in the order they are visited, a view into the catalogue.
+// A non-roundtrip route is stored one way only: for n stored stops the route has 2n - 1 stops,
+// the way back being the stored stops in reverse.
+class RouteView{
+public:
+    class Iterator{
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = StopId;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const StopId*;
+        using reference = StopId;
+
+        Iterator(const StopId* stops, size_t stored_count, size_t index)
+            : stops_(stops)
+            , stored_count_(stored_count)
+            , index_(index){
+        }
+        StopId operator*() const{
+            return index_ < stored_count_ ? stops_[index_] : stops_[stored_count_ * 2 - 2 - index_];
+        }
+        Iterator& operator++(){
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int){
+            Iterator result = *this;
+            ++index_;
+            return result;
+        }
+        bool operator==(const Iterator& other) const{
+            return index_ == other.index_;
+        }
+        bool operator!=(const Iterator& other) const{
+            return index_ != other.index_;
+        }
+
+    private:
+        const StopId* stops_;
+        size_t stored_count_;
+        size_t index_;
+    };
+
+    RouteView() = default;
+    RouteView(const StopId* stops, size_t stored_count, bool is_roundtrip)
+        : stops_(stops)
+        , stored_count_(stored_count)
+        , is_roundtrip_(is_roundtrip){
     }
 
-    std::string name;
-    tc::geo::Coordinates coordinates;
-};
+    size_t size() const{
+        return is_roundtrip_ || stored_count_ == 0 ? stored_count_ : stored_count_ * 2 - 1;
+    }
+    bool empty() const{
+        return stored_count_ == 0;
+    }
+    StopId operator[](size_t index) const{
+        return index < stored_count_ ? stops_[index] : stops_[stored_count_ * 2 - 2 - index];
+    }
+    Iterator begin() const{
+        return {stops_, stored_count_, 0};
+    }
+    Iterator end() const{
+        return {stops_, stored_count_, size()};
+    }
 
-struct Bus{
-    bool operator==(const Bus& other) const {
-        return name == other.name;
+    bool IsRoundtrip() const{
+        return is_roundtrip_;
+    }
+    // The whole route of a roundtrip bus, one way for the others
+    ranges::Range<const StopId*> GetStoredStops() const{
+        return {stops_, stops_ + stored_count_};
     }
 
-    std::string name;
-    std::vector<Stop*> stops;
-    bool is_roundtrip;
+private:
+    const StopId* stops_ = nullptr;
+    size_t stored_count_ = 0;
+    bool is_roundtrip_ = true;
 };
 
 } // namespace tc
@@ -2,19 +2,237 @@
 #include "geo.h"
 
 #include <cmath>
+#include <initializer_list>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace tc {
 namespace geo {
 
+static const double dr = M_PI / 180.;
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     if (from == to) {
         return 0;
     }
-    static const double dr = M_PI / 180.;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(std::abs(from.lng - to.lng) * dr))
-            * 6371000;
+            * EARTH_RADIUS;
+}
+
+void PointTable::Add(Coordinates point) {
+    lat.push_back(point.lat);
+    lng.push_back(point.lng);
+    sin_lat.push_back(std::sin(point.lat * dr));
+    cos_lat.push_back(std::cos(point.lat * dr));
+}
+
+Coordinates PointTable::Get(size_t index) const {
+    return {lat.at(index), lng.at(index)};
+}
+
+size_t PointTable::Size() const {
+    return lat.size();
+}
+
+namespace {
+
+// Distance by the expression of ComputeDistance with sine and cosine of the latitudes given
+double Distance(double sin_lat_a, double cos_lat_a, double sin_lat_b, double cos_lat_b, double lng_diff) {
+    return std::acos(sin_lat_a * sin_lat_b + cos_lat_a * cos_lat_b * std::cos(std::abs(lng_diff) * dr)) * EARTH_RADIUS;
+}
+
+#if defined(__SSE2__)
+
+// Polynomial cos and acos for two doubles, the coefficients are those of fdlibm, both are within 1-2 ulp.
+// Only the arguments of real distances are handled: |x| <= 16 for cos, |x| <= 1 for acos
+namespace sse2 {
+
+inline __m128d Polynomial(__m128d x, std::initializer_list<double> coefficients) {
+    // Horner's scheme from the highest coefficient
+    const double* c = coefficients.end();
+    __m128d result = _mm_set1_pd(*--c);
+    while (c != coefficients.begin()) {
+        result = _mm_add_pd(_mm_mul_pd(result, x), _mm_set1_pd(*--c));
+    }
+    return result;
+}
+
+inline __m128d Select(__m128d mask, __m128d if_set, __m128d if_not) {
+    return _mm_or_pd(_mm_and_pd(mask, if_set), _mm_andnot_pd(mask, if_not));
+}
+
+// x >= 0
+inline __m128d Cos(__m128d x) {
+    // x = k * pi / 2 + r, |r| <= pi / 4. pi / 2 is split in two parts, k * PIO2_HI is exact for small k
+    const __m128i k = _mm_cvtpd_epi32(_mm_mul_pd(x, _mm_set1_pd(6.36619772367581382433e-01)));
+    const __m128d kd = _mm_cvtepi32_pd(k);
+    const __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(kd, _mm_set1_pd(1.57079632673412561417e+00))),
+                                 _mm_mul_pd(kd, _mm_set1_pd(6.07710050650619224932e-11)));
+    const __m128d z = _mm_mul_pd(r, r);
+
+    // cos(r) = w + ((1 - w) - z / 2 + z * z * C(z)), w = 1 - z / 2
+    const __m128d half_z = _mm_mul_pd(z, _mm_set1_pd(0.5));
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d w = _mm_sub_pd(one, half_z);
+    const __m128d c = _mm_mul_pd(z, Polynomial(z, {4.16666666666666019037e-02, -1.38888888888741095749e-03,
+        2.48015872894767294178e-05, -2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11}));
+    const __m128d cos_r = _mm_add_pd(w, _mm_add_pd(_mm_sub_pd(_mm_sub_pd(one, w), half_z), _mm_mul_pd(z, c)));
+    // sin(r) = r + r * z * S(z)
+    const __m128d sin_r = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), Polynomial(z, {-1.66666666666666324348e-01,
+        8.33333333332248946124e-03, -1.98412698298579493134e-04, 2.75573137070700676789e-06,
+        -2.50507602534068634195e-08, 1.58969099521155010221e-10})));
+
+    // cos(x) is cos(r), -sin(r), -cos(r), sin(r) for k % 4 = 0, 1, 2, 3.
+    // k of lane i is in 32-bit element i, it is spread to both halves of the 64-bit lane
+    const __m128i k_lanes = _mm_shuffle_epi32(k, _MM_SHUFFLE(1, 1, 0, 0));
+    const __m128i one_i = _mm_set1_epi32(1);
+    const __m128i two_i = _mm_set1_epi32(2);
+    const __m128d is_sin = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(k_lanes, one_i), one_i));
+    const __m128d is_negative = _mm_castsi128_pd(
+        _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(k_lanes, one_i), two_i), two_i));
+    return _mm_xor_pd(Select(is_sin, sin_r, cos_r), _mm_and_pd(is_negative, _mm_set1_pd(-0.0)));
+}
+
+// acos(x) = 2 * asin(sqrt((1 - x) / 2)), asin(s) = s + s * R(s * s), R = P / Q
+inline __m128d AsinRatio(__m128d z) {
+    const __m128d p = _mm_mul_pd(z, Polynomial(z, {1.66666666666666657415e-01, -3.25565818622400915405e-01,
+        2.01212532134862925881e-01, -4.00555345006794114027e-02, 7.91534994289814532176e-04, 3.47933107596021167570e-05}));
+    const __m128d q = Polynomial(z, {1.0, -2.40339491173441421878e+00, 2.02094576023350569471e+00,
+        -6.88283971605453293030e-01, 7.70381505559019352791e-02});
+    return _mm_div_pd(p, q);
+}
+
+// |x| <= 1
+inline __m128d Acos(__m128d x) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d pio2_hi = _mm_set1_pd(1.57079632679489655800e+00);
+    const __m128d pio2_lo = _mm_set1_pd(6.12323399573676603587e-17);
+    const __m128d abs_x = _mm_andnot_pd(_mm_set1_pd(-0.0), x);
+
+    // |x| < 0.5: pi / 2 - (x + x * R(x * x))
+    const __m128d small = _mm_sub_pd(pio2_hi,
+        _mm_sub_pd(x, _mm_sub_pd(pio2_lo, _mm_mul_pd(x, AsinRatio(_mm_mul_pd(x, x))))));
+
+    // |x| >= 0.5: z = (1 - |x|) / 2, s = sqrt(z)
+    const __m128d z = _mm_mul_pd(_mm_sub_pd(one, abs_x), half);
+    const __m128d s = _mm_sqrt_pd(z);
+    const __m128d ratio = AsinRatio(z);
+    // x < -0.5: pi - 2 * (s + s * R(z) - pio2_lo)
+    const __m128d negative = _mm_sub_pd(_mm_set1_pd(3.14159265358979311600e+00),
+        _mm_mul_pd(_mm_set1_pd(2.0), _mm_add_pd(s, _mm_sub_pd(_mm_mul_pd(ratio, s), pio2_lo))));
+    // x > 0.5: 2 * (df + (c + s * R(z))), df is s with the low half cleared, c = (z - df * df) / (s + df)
+    const __m128d df = _mm_and_pd(s, _mm_castsi128_pd(_mm_set1_epi64x(static_cast<long long>(0xFFFFFFFF00000000ULL))));
+    const __m128d c = _mm_div_pd(_mm_sub_pd(z, _mm_mul_pd(df, df)), _mm_add_pd(s, df));
+    const __m128d positive = _mm_mul_pd(_mm_set1_pd(2.0), _mm_add_pd(df, _mm_add_pd(c, _mm_mul_pd(ratio, s))));
+
+    const __m128d is_small = _mm_cmplt_pd(abs_x, half);
+    return Select(is_small, small, Select(_mm_cmplt_pd(x, _mm_setzero_pd()), negative, positive));
+}
+
+} // namespace sse2
+
+// Two distances at once. Lanes the polynomials can not give within 1e-6 of ComputeDistance are marked in scalar_lanes:
+// when the argument of acos is near +-1 (points closer than about 300 m or nearly antipodal) its error
+// is amplified too much, and far out of range longitudes are not reduced
+inline __m128d Distances(__m128d sin_lat_a, __m128d cos_lat_a, __m128d sin_lat_b, __m128d cos_lat_b,
+                         __m128d lng_diff, int& scalar_lanes) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d angle = _mm_mul_pd(_mm_andnot_pd(sign, lng_diff), _mm_set1_pd(dr));
+    const __m128d x = _mm_add_pd(_mm_mul_pd(sin_lat_a, sin_lat_b),
+                                 _mm_mul_pd(_mm_mul_pd(cos_lat_a, cos_lat_b), sse2::Cos(angle)));
+    const __m128d is_scalar = _mm_or_pd(_mm_cmpgt_pd(_mm_andnot_pd(sign, x), _mm_set1_pd(1 - 1e-9)),
+                                        _mm_cmpnle_pd(angle, _mm_set1_pd(16.0)));
+    scalar_lanes = _mm_movemask_pd(is_scalar);
+    // Those lanes are replaced, acos must only not trap on them
+    const __m128d safe_x = _mm_andnot_pd(is_scalar, x);
+    return _mm_mul_pd(sse2::Acos(safe_x), _mm_set1_pd(EARTH_RADIUS));
+}
+
+#endif
+
+} // namespace
+
+// Both batch versions evaluate the expression of ComputeDistance with sine and cosine of latitudes
+// taken from the table. With SSE2 cos and acos are polynomials computed for two pairs at once, the distances
+// are within 1e-6 relative error of ComputeDistance; pairs for which the polynomials are not accurate enough
+// are computed with libm as without SSE2
+void ComputeDistances(const PointTable& points, const uint32_t* from, const uint32_t* to, size_t count, double* result) {
+    const double* lat = points.lat.data();
+    const double* lng = points.lng.data();
+    const double* sin_lat = points.sin_lat.data();
+    const double* cos_lat = points.cos_lat.data();
+    const auto is_same = [lat, lng](uint32_t a, uint32_t b) {
+        return std::abs(lat[a] - lat[b]) < THRESHOLD && std::abs(lng[a] - lng[b]) < THRESHOLD;
+    };
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 2 <= count; i += 2) {
+        const uint32_t a0 = from[i], a1 = from[i + 1];
+        const uint32_t b0 = to[i], b1 = to[i + 1];
+        int scalar_lanes = 0;
+        const __m128d distances = Distances(_mm_set_pd(sin_lat[a1], sin_lat[a0]), _mm_set_pd(cos_lat[a1], cos_lat[a0]),
+                                            _mm_set_pd(sin_lat[b1], sin_lat[b0]), _mm_set_pd(cos_lat[b1], cos_lat[b0]),
+                                            _mm_set_pd(lng[a1] - lng[b1], lng[a0] - lng[b0]), scalar_lanes);
+        _mm_storeu_pd(result + i, distances);
+        for (int lane = 0; lane < 2; ++lane) {
+            const uint32_t a = from[i + lane];
+            const uint32_t b = to[i + lane];
+            if (is_same(a, b)) {
+                result[i + lane] = 0;
+            } else if (scalar_lanes & (1 << lane)) {
+                result[i + lane] = Distance(sin_lat[a], cos_lat[a], sin_lat[b], cos_lat[b], lng[a] - lng[b]);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint32_t a = from[i];
+        const uint32_t b = to[i];
+        result[i] = is_same(a, b) ? 0 : Distance(sin_lat[a], cos_lat[a], sin_lat[b], cos_lat[b], lng[a] - lng[b]);
+    }
+}
+
+void ComputeDistances(Coordinates from, const PointTable& points, const uint32_t* to, size_t count, double* result) {
+    const double from_sin_lat = std::sin(from.lat * dr);
+    const double from_cos_lat = std::cos(from.lat * dr);
+    const double* lat = points.lat.data();
+    const double* lng = points.lng.data();
+    const double* sin_lat = points.sin_lat.data();
+    const double* cos_lat = points.cos_lat.data();
+    const auto is_same = [from, lat, lng](uint32_t b) {
+        return std::abs(from.lat - lat[b]) < THRESHOLD && std::abs(from.lng - lng[b]) < THRESHOLD;
+    };
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128d from_sin_lats = _mm_set1_pd(from_sin_lat);
+    const __m128d from_cos_lats = _mm_set1_pd(from_cos_lat);
+    const __m128d from_lngs = _mm_set1_pd(from.lng);
+    for (; i + 2 <= count; i += 2) {
+        const uint32_t b0 = to[i], b1 = to[i + 1];
+        int scalar_lanes = 0;
+        const __m128d distances = Distances(from_sin_lats, from_cos_lats,
+                                            _mm_set_pd(sin_lat[b1], sin_lat[b0]), _mm_set_pd(cos_lat[b1], cos_lat[b0]),
+                                            _mm_sub_pd(from_lngs, _mm_set_pd(lng[b1], lng[b0])), scalar_lanes);
+        _mm_storeu_pd(result + i, distances);
+        for (int lane = 0; lane < 2; ++lane) {
+            const uint32_t b = to[i + lane];
+            if (is_same(b)) {
+                result[i + lane] = 0;
+            } else if (scalar_lanes & (1 << lane)) {
+                result[i + lane] = Distance(from_sin_lat, from_cos_lat, sin_lat[b], cos_lat[b], from.lng - lng[b]);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint32_t b = to[i];
+        result[i] = is_same(b) ? 0 : Distance(from_sin_lat, from_cos_lat, sin_lat[b], cos_lat[b], from.lng - lng[b]);
+    }
 }
 
 }  // namespace geo
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace tc{
 namespace geo{
 
 static const double THRESHOLD = 1e-6;
+static const double EARTH_RADIUS = 6371000;
 
 struct Coordinates {
     double lat;
@@ -20,5 +24,23 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Points kept as parallel arrays together with sine and cosine of their latitudes,
+// so distances between them are computed without recomputing those for every pair
+struct PointTable{
+    std::vector<double> lat;
+    std::vector<double> lng;
+    std::vector<double> sin_lat;
+    std::vector<double> cos_lat;
+
+    void Add(Coordinates point);
+    Coordinates Get(size_t index) const;
+    size_t Size() const;
+};
+
+// result[i] = ComputeDistance(points[from[i]], points[to[i]]) for i < count, within 1e-6 relative error
+void ComputeDistances(const PointTable& points, const uint32_t* from, const uint32_t* to, size_t count, double* result);
+// result[i] = ComputeDistance(from, points[to[i]]) for i < count, within 1e-6 relative error
+void ComputeDistances(Coordinates from, const PointTable& points, const uint32_t* to, size_t count, double* result);
+
 } // namespace geo
 } // namespace tc
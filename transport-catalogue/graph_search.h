@@ -0,0 +1,126 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+template <typename Weight>
+inline constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+
+template <typename Weight>
+struct Path {
+    Weight weight;
+    std::vector<EdgeId> edges;
+};
+
+// Returns graph with the same vertices and every edge turned backwards.
+// Edge ids of the reversed graph match edge ids of the original one.
+template <typename Weight>
+DirectedWeightedGraph<Weight> MakeReversedGraph(const DirectedWeightedGraph<Weight>& graph) {
+    DirectedWeightedGraph<Weight> reversed(graph.GetVertexCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        reversed.AddEdge({edge.to, edge.from, edge.weight});
+    }
+    return reversed;
+}
+
+// Dijkstra from source over the whole graph, unreachable vertices get UNREACHABLE
+template <typename Weight>
+std::vector<Weight> ComputeDistances(const DirectedWeightedGraph<Weight>& graph, VertexId source) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::vector<Weight> distances(graph.GetVertexCount(), UNREACHABLE<Weight>);
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    distances.at(source) = Weight{};
+    queue.push({Weight{}, source});
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > distances[vertex]) {
+            continue;
+        }
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < Weight{}) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const Weight candidate = weight + edge.weight;
+            if (candidate < distances[edge.to]) {
+                distances[edge.to] = candidate;
+                queue.push({candidate, edge.to});
+            }
+        }
+    }
+    return distances;
+}
+
+// A* search from one vertex to another.
+// heuristic(vertex) must not overestimate the remaining weight to the target,
+// is_edge_allowed(edge_id) lets the caller hide edges from the search.
+template <typename Weight, typename Heuristic, typename EdgeFilter>
+std::optional<Path<Weight>> FindShortestPath(const DirectedWeightedGraph<Weight>& graph,
+                                             VertexId from, VertexId to,
+                                             Heuristic&& heuristic, EdgeFilter&& is_edge_allowed) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<Weight> weights(vertex_count, UNREACHABLE<Weight>);
+    std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    weights.at(from) = Weight{};
+    queue.push({heuristic(from), from});
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        const Weight estimate = queue.top().first;
+        queue.pop();
+        if (vertex == to) {
+            break;
+        }
+        const Weight weight = weights[vertex];
+        if (estimate > weight + heuristic(vertex)) {
+            continue;
+        }
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            if (!is_edge_allowed(edge_id)) {
+                continue;
+            }
+            const auto& edge = graph.GetEdge(edge_id);
+            const Weight candidate = weight + edge.weight;
+            if (candidate < weights[edge.to]) {
+                weights[edge.to] = candidate;
+                prev_edges[edge.to] = edge_id;
+                queue.push({candidate + heuristic(edge.to), edge.to});
+            }
+        }
+    }
+
+    if (weights.at(to) == UNREACHABLE<Weight>) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = prev_edges[to]; edge_id; edge_id = prev_edges[graph.GetEdge(*edge_id).from]) {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return Path<Weight>{weights[to], std::move(edges)};
+}
+
+template <typename Weight, typename Heuristic>
+std::optional<Path<Weight>> FindShortestPath(const DirectedWeightedGraph<Weight>& graph,
+                                             VertexId from, VertexId to, Heuristic&& heuristic) {
+    return FindShortestPath(graph, from, to, std::forward<Heuristic>(heuristic),
+                            [](EdgeId) { return true; });
+}
+
+}  // namespace graph
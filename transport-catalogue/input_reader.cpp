@@ -63,6 +63,8 @@ void ParseInput(TransportCatalogue& tc, const vector<string>& queries){
             data::AddBus(tc, item);
         }
     }
+
+    tc.Finalize();
 }
 
 namespace service{
@@ -122,7 +124,7 @@ void AddStop(TransportCatalogue& tc, const vector<string_view>& query){
 //    from_chars(sv_lng.begin(), sv_lng.begin() + sv_lng.size(), lng);
 
     // query[1] - stop_name ; query[2] - lat ; query[3] - lng
-    tc.AddStop(string(query[1]), std::stod(string(query[2])), std::stod(string(query[3])));
+    tc.AddStop(query[1], std::stod(string(query[2])), std::stod(string(query[3])));
 }
 
 void AddStopsDistance(TransportCatalogue& tc, const vector<string_view>& query){
@@ -140,19 +142,12 @@ void AddBus(TransportCatalogue& tc, const vector<string_view>& query){
     string_view bus_name = query[1];
     if (query[2] == ">"sv){
         vector<string_view> stops_for_bus(query.begin() + 3, query.end());
-        tc.AddBus(string(bus_name), stops_for_bus, true);
+        tc.AddBus(bus_name, stops_for_bus, true);
         return;
     }
     if (query[2] == "-"sv){
-        vector<string_view> stops_for_bus;
-        stops_for_bus.reserve((query.size() - 3) * 2);
-        for(auto it = query.begin() + 3; it < query.end(); ++it){
-            stops_for_bus.push_back(*it);
-        }
-        for(auto it = query.rbegin() + 1; it < query.rend() - 3; ++it){
-            stops_for_bus.push_back(*it);
-        }
-        tc.AddBus(string(bus_name), stops_for_bus, false);
+        vector<string_view> stops_for_bus(query.begin() + 3, query.end());
+        tc.AddBus(bus_name, stops_for_bus, false);
         return;
     }
 }
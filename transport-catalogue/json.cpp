@@ -1,6 +1,12 @@
 #include "json.h"
+#include "char_scan.h"
+#include "number_format.h"
 
+#include <algorithm>
+#include <charconv>
+#include <iterator>
 #include <stdexcept>
+#include <system_error>
 
 using namespace std;
 
@@ -8,208 +14,507 @@ namespace json {
 
 namespace {
 
-Node LoadNode(istream& input);
+using Number = std::variant<int, double>;
 
-Node LoadArray(istream& input) {
-    Array result;
-    char c;
-    for (; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+// Reads the tokens of a text kept in memory as a whole, or of a stream read in chunks:
+// then only the token being read and the rest of the chunk are kept
+class Lexer {
+public:
+    explicit Lexer(string_view text)
+        : pos_(text.data())
+        , end_(text.data() + text.size()) {
+    }
+    explicit Lexer(istream& input)
+        : input_(&input)
+        , pos_(chunk_.data())
+        , end_(pos_) {
+    }
+
+protected:
+    // Arrays and dicts nested deeper are rejected before the recursion of the parsers exhausts the stack
+    static constexpr size_t MAX_DEPTH = 1000;
+
+    // Counts the array or dict being read for the time it is read
+    class NestingGuard {
+    public:
+        explicit NestingGuard(Lexer& lexer)
+            : depth_(lexer.depth_) {
+            if (depth_ == MAX_DEPTH) {
+                throw ParsingError("Nesting is too deep"s);
+            }
+            ++depth_;
         }
-        result.push_back(LoadNode(input));
+        NestingGuard(const NestingGuard&) = delete;
+        NestingGuard& operator=(const NestingGuard&) = delete;
+        ~NestingGuard() {
+            --depth_;
+        }
+
+    private:
+        size_t& depth_;
+    };
+
+    // Not set for a text in memory
+    istream* input_ = nullptr;
+    string chunk_;
+    const char* pos_;
+    const char* end_;
+    size_t depth_ = 0;
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
     }
-    if (c != ']'){
-        throw ParsingError("ParsingError exception is expected on ']'"s);
+    static bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
     }
 
-    return Node(move(result));
+    // Reads more of the stream when pos_ has reached end_. The text from keep on (the token being read)
+    // stays, keep and pos_ are moved with it. Returns false at the end of the input
+    bool Refill(const char*& keep);
+    bool Refill() {
+        return Refill(pos_);
+    }
+
+    // Skips whitespace and returns the next char without consuming it, '\0' at the end of the text
+    char PeekChar();
+    // Skips whitespace and consumes the next char
+    char NextChar();
+
+    // Called after the opening quote. The result points into the text when the string has no escapes,
+    // otherwise the string is unescaped into buffer
+    string_view LoadString(string& buffer);
+    // Called before the first char of the literal
+    void LoadLiteral(string_view literal);
+    Number LoadNumber();
+};
+
+bool Lexer::Refill(const char*& keep) {
+    if (input_ == nullptr || !*input_) {
+        return false;
+    }
+    const size_t kept = static_cast<size_t>(end_ - keep);
+    const size_t keep_to_pos = static_cast<size_t>(pos_ - keep);
+    chunk_.erase(0, static_cast<size_t>(keep - chunk_.data()));
+    // Grows with a long token, so it is not moved too many times
+    const size_t chunk_size = max<size_t>(64 * 1024, kept);
+    chunk_.resize(kept + chunk_size);
+    input_->read(chunk_.data() + kept, static_cast<streamsize>(chunk_size));
+    chunk_.resize(kept + static_cast<size_t>(input_->gcount()));
+    keep = chunk_.data();
+    pos_ = keep + keep_to_pos;
+    end_ = chunk_.data() + chunk_.size();
+    return pos_ != end_;
+}
+
+char Lexer::PeekChar() {
+    do {
+        while (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+        }
+    } while (pos_ == end_ && Refill());
+    return pos_ != end_ ? *pos_ : '\0';
 }
 
-Node LoadString(std::istream& input) {
-    using namespace std::literals;
+char Lexer::NextChar() {
+    if (PeekChar() == '\0' && pos_ == end_) {
+        throw ParsingError("Unexpected end of input"s);
+    }
+    return *pos_++;
+}
 
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
+string_view Lexer::LoadString(string& buffer) {
+    const char* run = pos_;
+    bool escaped = false;
     while (true) {
-        if (it == end) {
+        // Plain chars are skipped in blocks
+        pos_ = char_scan::FindAnyOf<'"', '\\', '\n', '\r'>(pos_, end_);
+        if (pos_ == end_) {
+            if (Refill(run)) {
+                continue;
+            }
             throw ParsingError("String parsing error");
         }
-        const char ch = *it;
+        const char ch = *pos_;
         if (ch == '"') {
-             ++it;
-            break;
+            if (!escaped) {
+                return string_view(run, pos_++ - run);
+            }
+            buffer.append(run, pos_);
+            ++pos_;
+            return buffer;
         } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+            if (!escaped) {
+                buffer.clear();
+                escaped = true;
+            }
+            buffer.append(run, pos_);
+            if (++pos_ == end_ && !Refill()) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
+            const char escaped_char = *pos_;
             switch (escaped_char) {
                 case 'n':
-                    s.push_back('\n');
+                    buffer.push_back('\n');
                     break;
                 case 't':
-                    s.push_back('\t');
+                    buffer.push_back('\t');
                     break;
                 case 'r':
-                    s.push_back('\r');
+                    buffer.push_back('\r');
                     break;
                 case '"':
-                    s.push_back('"');
+                    buffer.push_back('"');
                     break;
                 case '\\':
-                    s.push_back('\\');
+                    buffer.push_back('\\');
                     break;
                 default:
                     throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
+            run = ++pos_;
         } else {
-            s.push_back(ch);
+            throw ParsingError("Unexpected end of line"s);
         }
-        ++it;
     }
-//    std::cerr << s << std::endl;
-
-    return Node(move(s));;
 }
 
-Node LoadNull(istream& input) {
-    char str[5];
-    input.get(str, 5);
-    if(string(str) == "null"s){
-        return Node();
-    } else {
-        throw ParsingError("Failed to read null from stream"s);
+void Lexer::LoadLiteral(string_view literal) {
+    while (static_cast<size_t>(end_ - pos_) < literal.size() && Refill()) {
     }
-
+    if (static_cast<size_t>(end_ - pos_) < literal.size() || string_view(pos_, literal.size()) != literal) {
+        throw ParsingError("Failed to read "s + string(literal) + " from stream"s);
+    }
+    pos_ += literal.size();
 }
 
-Node LoadBool(istream& input) {
-    int size = (input.peek() == 't') ? 5 : 6;
-    char str[6];
-    input.get(str, size);
-    if(string(str) == "true"sv){
-        return Node(true);
-    } else if (string(str) == "false"sv){
-        return Node(false);
+Number Lexer::LoadNumber() {
+    const char* begin = pos_;
+    // Whether there is a next char, the number read so far stays in the chunk
+    const auto has_char = [this, &begin] {
+        return pos_ != end_ || Refill(begin);
+    };
+
+    auto read_digits = [this, &has_char] {
+        if (!has_char() || !IsDigit(*pos_)) {
+            throw ParsingError("A digit is expected"s);
+        }
+        while (has_char() && IsDigit(*pos_)) {
+            ++pos_;
+        }
+    };
+
+    if (has_char() && *pos_ == '-') {
+        ++pos_;
+    }
+    if (has_char() && *pos_ == '0') {
+        ++pos_;
     } else {
-        throw ParsingError("Failed to read bool from stream"s);
+        read_digits();
     }
 
-}
+    bool is_int = true;
+    if (has_char() && *pos_ == '.') {
+        ++pos_;
+        read_digits();
+        is_int = false;
+    }
 
-Node LoadDict(istream& input) {
-    Dict result;
-    char c;
-    for (; input >> c && c != '}';) {
-        if (c == ',') {
-            input >> c;
+    if (has_char() && (*pos_ == 'e' || *pos_ == 'E')) {
+        ++pos_;
+        if (has_char() && (*pos_ == '+' || *pos_ == '-')) {
+            ++pos_;
         }
+        read_digits();
+        is_int = false;
+    }
 
-        string key = LoadString(input).AsString();
-        input >> c;
-        result.insert({move(key), LoadNode(input)});
+    // Integers which do not fit int are read as double
+    if (is_int) {
+        int value = 0;
+        if (auto [ptr, ec] = from_chars(begin, pos_, value); ec == errc{} && ptr == pos_) {
+            return value;
+        }
     }
-    if (c != '}'){
-        throw ParsingError("ParsingError exception is expected on '}'"s);
+    double value = 0;
+    if (auto [ptr, ec] = from_chars(begin, pos_, value); ec != errc{} || ptr != pos_) {
+        throw ParsingError("Failed to convert "s + string(begin, pos_) + " to number"s);
     }
-    return Node(move(result));
+    return value;
 }
 
-using Number = std::variant<int, double>;
-
-Number LoadNumber(std::istream& input) {
-    using namespace std::literals;
-
-    std::string parsed_num;
+// Recursive descent parser building the Node tree, arrays and dicts are allocated from the arena
+class Parser : private Lexer {
+public:
+    Parser(string_view text, pmr::memory_resource* arena)
+        : Lexer(text)
+        , arena_(arena) {
+    }
 
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
+    Node LoadNode();
+
+private:
+    pmr::memory_resource* arena_;
+    // Elements of the arrays being read: an array is allocated in the arena only once, at its full size,
+    // since the arena can not reuse the memory of an outgrown one
+    vector<Node> elements_;
+    // Members of the dicts being read, for the same reason
+    vector<Dict::value_type> members_;
+
+    Node LoadArray();
+    Node LoadDict();
+    string LoadString();
+};
+
+Node Parser::LoadArray() {
+    const NestingGuard guard(*this);
+    Array result(arena_);
+    if (PeekChar() == ']') {
+        ++pos_;
+        return Node(move(result));
+    }
+    const size_t first = elements_.size();
+    while (true) {
+        elements_.push_back(LoadNode());
+        const char c = NextChar();
+        if (c == ']') {
+            break;
         }
-    };
+        if (c != ',') {
+            throw ParsingError("ParsingError exception is expected on ']'"s);
+        }
+    }
+    result.reserve(elements_.size() - first);
+    move(elements_.begin() + static_cast<ptrdiff_t>(first), elements_.end(), back_inserter(result));
+    elements_.resize(first);
+    return Node(move(result));
+}
 
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+Node Parser::LoadDict() {
+    const NestingGuard guard(*this);
+    char c = NextChar();
+    if (c == '}') {
+        return Node(Dict(arena_));
+    }
+    const size_t first = members_.size();
+    while (true) {
+        if (c != '"') {
+            throw ParsingError("Dict key is expected"s);
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        string key = LoadString();
+        if (NextChar() != ':') {
+            throw ParsingError("':' is expected after dict key"s);
         }
-    };
+        Node value = LoadNode();
+        members_.emplace_back(move(key), move(value));
+        c = NextChar();
+        if (c == '}') {
+            break;
+        }
+        if (c != ',') {
+            throw ParsingError("ParsingError exception is expected on '}'"s);
+        }
+        c = NextChar();
+    }
+    Dict::Items items(arena_);
+    items.reserve(members_.size() - first);
+    move(members_.begin() + static_cast<ptrdiff_t>(first), members_.end(), back_inserter(items));
+    members_.resize(first);
+    return Node(Dict(move(items)));
+}
+
+string Parser::LoadString() {
+    string buffer;
+    const string_view str = Lexer::LoadString(buffer);
+    if (str.data() == buffer.data()) {
+        return buffer;
+    }
+    return string(str);
+}
 
-    if (input.peek() == '-') {
-        read_char();
+Node Parser::LoadNode() {
+    const char c = NextChar();
+    if (c == '[') {
+        return LoadArray();
+    } else if (c == '{') {
+        return LoadDict();
+    } else if (c == '"') {
+        return Node(LoadString());
     }
-    if (input.peek() == '0') {
-        read_char();
-    } else {
-        read_digits();
+    --pos_;
+    if (c == 'n') {
+        LoadLiteral("null"sv);
+        return Node();
+    } else if (c == 't') {
+        LoadLiteral("true"sv);
+        return Node(true);
+    } else if (c == 'f') {
+        LoadLiteral("false"sv);
+        return Node(false);
     }
+    return visit([](auto value) { return Node(value); }, LoadNumber());
+}
 
-    bool is_int = true;
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+// Recursive descent parser passing the values to the handler
+class EventParser : private Lexer {
+public:
+    EventParser(string_view text, Handler& handler)
+        : Lexer(text)
+        , handler_(handler) {
+    }
+    EventParser(istream& input, Handler& handler)
+        : Lexer(input)
+        , handler_(handler) {
     }
 
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    void ParseValue();
+
+private:
+    Handler& handler_;
+    // Unescaped strings, reused to avoid allocations
+    string buffer_;
+
+    void ParseArray();
+    void ParseDict();
+};
+
+void EventParser::ParseArray() {
+    const NestingGuard guard(*this);
+    handler_.StartArray();
+    if (PeekChar() == ']') {
+        ++pos_;
+        handler_.EndArray();
+        return;
+    }
+    while (true) {
+        ParseValue();
+        const char c = NextChar();
+        if (c == ']') {
+            break;
+        }
+        if (c != ',') {
+            throw ParsingError("ParsingError exception is expected on ']'"s);
         }
-        read_digits();
-        is_int = false;
     }
+    handler_.EndArray();
+}
 
-    try {
-        if (is_int) {
-             try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-            }
+void EventParser::ParseDict() {
+    const NestingGuard guard(*this);
+    handler_.StartDict();
+    char c = NextChar();
+    if (c == '}') {
+        handler_.EndDict();
+        return;
+    }
+    while (true) {
+        if (c != '"') {
+            throw ParsingError("Dict key is expected"s);
+        }
+        handler_.Key(LoadString(buffer_));
+        if (NextChar() != ':') {
+            throw ParsingError("':' is expected after dict key"s);
+        }
+        ParseValue();
+        c = NextChar();
+        if (c == '}') {
+            break;
+        }
+        if (c != ',') {
+            throw ParsingError("ParsingError exception is expected on '}'"s);
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        c = NextChar();
     }
+    handler_.EndDict();
 }
 
-Node LoadNode(istream& input) {
-    char c;
-    input >> c;
-//    std::cerr << "LoadNode"s << std::endl;
+void EventParser::ParseValue() {
+    const char c = NextChar();
     if (c == '[') {
-        return LoadArray(input);
+        ParseArray();
+        return;
     } else if (c == '{') {
-        return LoadDict(input);
+        ParseDict();
+        return;
     } else if (c == '"') {
-        return LoadString(input);
-    } else if (c == 'n') {
-        input.putback(c);
-        return LoadNull(input);
-    } else if (c == 't' || c == 'f') {
-        input.putback(c);
-        return LoadBool(input);
+        handler_.String(LoadString(buffer_));
+        return;
+    }
+    --pos_;
+    if (c == 'n') {
+        LoadLiteral("null"sv);
+        handler_.Null();
+    } else if (c == 't') {
+        LoadLiteral("true"sv);
+        handler_.Bool(true);
+    } else if (c == 'f') {
+        LoadLiteral("false"sv);
+        handler_.Bool(false);
+    } else if (const Number number = LoadNumber(); holds_alternative<int>(number)) {
+        handler_.Int(get<int>(number));
     } else {
-        input.putback(c);
-        auto num = LoadNumber(input);
-        if (holds_alternative<double>(num)){
-            return Node(get<double>(num));
-        }
-        return Node(get<int>(num));
+        handler_.Double(get<double>(number));
+    }
+}
+
+// The whole input is read in large chunks, the parsers never touch the stream
+string ReadAll(istream& input) {
+    string text;
+    char buffer[64 * 1024];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+        text.append(buffer, static_cast<size_t>(input.gcount()));
     }
+    return text;
 }
 
 }  // namespace
 
 
+// ------- Dict -------
+
+Dict::Dict(pmr::memory_resource* resource)
+    : items_(resource) {
+}
+
+Dict::Dict(Items items)
+    : items_(move(items)) {
+    const auto by_key = [](const value_type& lhs, const value_type& rhs) { return lhs.first < rhs.first; };
+    if (is_sorted(items_.begin(), items_.end(), by_key)
+            && adjacent_find(items_.begin(), items_.end(), [](const value_type& lhs, const value_type& rhs) {
+                   return lhs.first == rhs.first; }) == items_.end()) {
+        return;
+    }
+    // Stable, so the first of equal keys is the one met first
+    stable_sort(items_.begin(), items_.end(), by_key);
+    items_.erase(unique(items_.begin(), items_.end(), [](const value_type& lhs, const value_type& rhs) {
+        return lhs.first == rhs.first; }), items_.end());
+}
+
+pair<Dict::iterator, bool> Dict::emplace(string key, Node value) {
+    const auto it = items_.begin() + static_cast<ptrdiff_t>(LowerBound(key));
+    if (it != items_.end() && it->first == key) {
+        return {it, false};
+    }
+    return {items_.emplace(it, move(key), move(value)), true};
+}
+
+Node& Dict::operator[](string_view key) {
+    const auto it = items_.begin() + static_cast<ptrdiff_t>(LowerBound(key));
+    if (it != items_.end() && it->first == key) {
+        return it->second;
+    }
+    return items_.emplace(it, string(key), Node())->second;
+}
+
+bool operator== (const Dict& lhs, const Dict& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+bool operator!= (const Dict& lhs, const Dict& rhs) {
+    return !(lhs == rhs);
+}
+
+// ------- Node -------
+
 bool Node::IsArray() const{
     return holds_alternative<Array>(value_);
 }
@@ -310,6 +615,15 @@ Document::Document(Node root)
     : root_(move(root)) {
 }
 
+Document& Document::operator=(Document&& other) noexcept {
+    if (this != &other) {
+        root_ = Node();
+        arena_ = move(other.arena_);
+        root_ = move(other.root_);
+    }
+    return *this;
+}
+
 const Node& Document::GetRoot() const {
     return root_;
 }
@@ -322,7 +636,89 @@ bool operator!= (const json::Document& lhs, const json::Document& rhs){
 }
 
 Document Load(istream& input) {
-    return Document{LoadNode(input)};
+    return Load(string_view(ReadAll(input)));
+}
+
+Document Load(string_view text) {
+    // The tree takes about as much memory as the text, so the arena starts with that
+    auto arena = make_unique<pmr::monotonic_buffer_resource>(max<size_t>(text.size(), 1024));
+    Document document{Parser(text, arena.get()).LoadNode()};
+    document.arena_ = move(arena);
+    return document;
+}
+
+// ------ Events ------
+
+void Parse(istream& input, Handler& handler) {
+    EventParser(input, handler).ParseValue();
+}
+
+void Parse(string_view text, Handler& handler) {
+    EventParser(text, handler).ParseValue();
+}
+
+void TreeHandler::StartDict() {
+    Add(Dict{}, true);
+}
+
+void TreeHandler::Key(string_view key) {
+    key_ = key;
+}
+
+void TreeHandler::EndDict() {
+    stack_.pop_back();
+}
+
+void TreeHandler::StartArray() {
+    Add(Array{}, true);
+}
+
+void TreeHandler::EndArray() {
+    stack_.pop_back();
+}
+
+void TreeHandler::String(string_view value) {
+    Add(std::string(value), false);
+}
+
+void TreeHandler::Int(int value) {
+    Add(value, false);
+}
+
+void TreeHandler::Double(double value) {
+    Add(value, false);
+}
+
+void TreeHandler::Bool(bool value) {
+    Add(value, false);
+}
+
+void TreeHandler::Null() {
+    Add(Node(), false);
+}
+
+Node TreeHandler::Extract() {
+    Node result = move(root_);
+    root_ = Node();
+    stack_.clear();
+    return result;
+}
+
+void TreeHandler::Add(Node value, bool is_container) {
+    Node* added = &root_;
+    if (stack_.empty()) {
+        root_ = move(value);
+    } else if (Array* array = get_if<Array>(&stack_.back()->GetValue())) {
+        array->push_back(move(value));
+        added = &array->back();
+    } else {
+        // The first of repeated keys is kept, as Load does
+        added = &get<Dict>(stack_.back()->GetValue()).emplace(move(key_), move(value)).first->second;
+    }
+    // An opened container is filled before anything is added to its parent, so the pointer stays valid
+    if (is_container) {
+        stack_.push_back(added);
+    }
 }
 
 // ------ Print ------
@@ -352,26 +748,27 @@ void PrintValue(std::nullptr_t, const PrintContext& ctx) {
     //ctx.PrintIndent();
     ctx.out << "null"sv;
 }
+// Print double, the shortest text which reads back as the same value
+void PrintValue(double value, const PrintContext& ctx) {
+    number_format::PrintDouble(ctx.out, value);
+}
 // Print string
 void PrintValue(const std::string& str, const PrintContext& ctx) {
 //    cerr << str << endl;
     //ctx.PrintIndent();
     ctx.out << "\""sv;
-    for (const auto& c : str){
-        if (c == '\\'){
-            ctx.out << '\\';
-        } else if (c == '\"'){
-            ctx.out << '\\';
-        } else if (c == '\r'){
-            ctx.out << '\\';
-            ctx.out << 'r';
-            continue;
-        } else if (c == '\n'){
-            ctx.out << '\\';
-            ctx.out << 'n';
-            continue;
+    // Runs of chars which need no escaping are written as a whole
+    const char* pos = str.data();
+    const char* const end = pos + str.size();
+    while (true) {
+        const char* special = char_scan::FindAnyOf<'"', '\\', '\n', '\r'>(pos, end);
+        ctx.out.write(pos, special - pos);
+        if (special == end) {
+            break;
         }
-        ctx.out << c;
+        ctx.out << '\\';
+        ctx.out << (*special == '\r' ? 'r' : *special == '\n' ? 'n' : *special);
+        pos = special + 1;
     }
     ctx.out << "\""sv;
 }
@@ -1,16 +1,67 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+
+// Only the storage of arrays and dicts of a tree made by Load comes from the arena of its Document.
+// Strings and dict keys are std::string, longer ones are allocated from the heap as usual,
+// and trees made in other ways (Builder, TreeHandler) use only the heap.
+// A copy is always allocated from the heap, so it may outlive the document
+using Array = std::pmr::vector<Node>;
+
+// Members of a JSON object in one vector sorted by key, so they are iterated in key order as std::map would do.
+// Small dicts are searched linearly, larger ones by binary search
+class Dict {
+public:
+    using value_type = std::pair<std::string, Node>;
+    using Items = std::pmr::vector<value_type>;
+    using iterator = Items::iterator;
+    using const_iterator = Items::const_iterator;
+
+    Dict() = default;
+    explicit Dict(std::pmr::memory_resource* resource);
+    // Items may come in any order, the first of repeated keys is kept
+    explicit Dict(Items items);
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const;
+    bool empty() const;
+
+    const_iterator find(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    // Throws std::out_of_range if there is no such key
+    const Node& at(std::string_view key) const;
+
+    // Does nothing if the key is already there, returns the member with the key
+    std::pair<iterator, bool> emplace(std::string key, Node value);
+    // Adds null value if there is no such key
+    Node& operator[](std::string_view key);
+
+private:
+    static constexpr size_t LINEAR_SEARCH_SIZE = 8;
+
+    Items items_;
+
+    // Index of the first member with the key not less than key
+    size_t LowerBound(std::string_view key) const;
+};
+
+bool operator== (const Dict& lhs, const Dict& rhs);
+bool operator!= (const Dict& lhs, const Dict& rhs);
 
 // Exception in JSON
 class ParsingError : public std::runtime_error {
@@ -55,20 +106,130 @@ private:
 bool operator== (const json::Node& lhs, const json::Node& rhs);
 bool operator!= (const json::Node& lhs, const json::Node& rhs);
 
+inline Dict::const_iterator Dict::begin() const {
+    return items_.begin();
+}
+
+inline Dict::const_iterator Dict::end() const {
+    return items_.end();
+}
+
+inline size_t Dict::size() const {
+    return items_.size();
+}
+
+inline bool Dict::empty() const {
+    return items_.empty();
+}
+
+inline size_t Dict::LowerBound(std::string_view key) const {
+    if (items_.size() <= LINEAR_SEARCH_SIZE) {
+        size_t i = 0;
+        while (i < items_.size() && items_[i].first < key) {
+            ++i;
+        }
+        return i;
+    }
+    return static_cast<size_t>(std::lower_bound(items_.begin(), items_.end(), key,
+        [](const value_type& item, std::string_view key) { return item.first < key; }) - items_.begin());
+}
+
+inline Dict::const_iterator Dict::find(std::string_view key) const {
+    const auto it = items_.begin() + static_cast<std::ptrdiff_t>(LowerBound(key));
+    return it != items_.end() && it->first == key ? it : items_.end();
+}
+
+inline size_t Dict::count(std::string_view key) const {
+    return find(key) != items_.end() ? 1 : 0;
+}
+
+inline const Node& Dict::at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == items_.end()) {
+        throw std::out_of_range("Dict::at");
+    }
+    return it->second;
+}
+
 class Document {
 public:
     explicit Document(Node root);
+    Document(Document&& other) noexcept = default;
+    // The old tree is released before its arena, only then the other one is taken
+    Document& operator=(Document&& other) noexcept;
 
     const Node& GetRoot() const;
 
 private:
+    friend Document Load(std::string_view text);
+
+    // Storage of the arrays and dicts of a parsed tree (not of its strings) is allocated here
+    // and released at once with the document. It is declared first, so it outlives the tree
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
     Node root_;
 };
 
 bool operator== (const json::Document& lhs, const json::Document& rhs);
 bool operator!= (const json::Document& lhs, const json::Document& rhs);
 
+// Reads the whole input first, then parses it
 Document Load(std::istream& input);
+// The text has to contain one JSON value, anything after it is ignored.
+// Arrays and dicts nested deeper than 1000 levels throw ParsingError
+Document Load(std::string_view text);
+
+// Receives the values of a JSON text in document order without building the tree.
+// Views passed to Key and String are valid only during the call
+class Handler {
+public:
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void String(std::string_view value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Null() = 0;
+
+protected:
+    ~Handler() = default;
+};
+
+// Reads one JSON value and passes it to the handler. A stream is read in chunks of 64 KiB while the value
+// is parsed, only the chunk is kept (or a longer token with it). The nesting limit is the same as for Load
+void Parse(std::istream& input, Handler& handler);
+void Parse(std::string_view text, Handler& handler);
+
+// Builds the Node of the value it receives, so a handler can keep some parts of the text as nodes.
+// Its containers are allocated from the heap, not from an arena: the kept parts are small
+// (one request, one settings section) and often outlive the text, e.g. in another thread.
+// So make_base and process_requests, which read their input through handlers, do not use the arena,
+// only Load does (e.g. for the lines of serve)
+class TreeHandler final : public Handler {
+public:
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void String(std::string_view value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void Bool(bool value) override;
+    void Null() override;
+
+    // Takes the built value and makes the handler ready for the next one
+    Node Extract();
+
+private:
+    Node root_;
+    std::vector<Node*> stack_;
+    std::string key_;
+
+    void Add(Node value, bool is_container);
+};
 
 struct PrintContext  {
     PrintContext (std::ostream& out);
@@ -88,6 +249,7 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 void PrintValue(std::nullptr_t, const PrintContext& ctx);
+void PrintValue(double value, const PrintContext& ctx);
 void PrintValue(const std::string& str, const PrintContext& ctx);
 void PrintValue(bool b, const PrintContext& ctx);
 void PrintValue(const Array& arr, const PrintContext& ctx);
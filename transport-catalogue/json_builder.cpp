@@ -6,7 +6,7 @@ using namespace std;
 
 namespace json{
 
-KeyContext Builder::Key(string key){
+KeyContext<Builder> Builder::Key(string key){
     //cerr << "Key() : begin "sv << endl;
     if (nodes_stack_.empty() || expects_build_method){
         throw std::logic_error("error Key(string key) : no opened Nodes"s);
@@ -41,7 +41,7 @@ Builder& Builder::Value(Node::Value value){
     return (*this);
 }
 
-DictContext Builder::StartDict(){
+DictContext<Builder> Builder::StartDict(){
     if (expects_build_method){
         throw std::logic_error("Need be Build() after Value()"s);
     }
@@ -78,7 +78,7 @@ Builder& Builder::EndDict(){
     return *this;
 }
 
-ArrayContext Builder::StartArray(){
+ArrayContext<Builder> Builder::StartArray(){
     if (expects_build_method){
         throw std::logic_error("Need be Build() after Value()"s);
     }
@@ -122,32 +122,5 @@ Node Builder::Build(){
     return root_;
 }
 
-KeyContext BuilderContext::Key(std::string key){
-    return builder_.Key(move(key));
-}
-
-KeyValueContext KeyContext::Value(Node::Value value){
-    builder_.Value(move(value));
-    return KeyValueContext(builder_);
-}
-
-ArrayContext ArrayContext::Value(Node::Value value){
-    builder_.Value(move(value));
-    return ArrayContext(builder_);
-}
-
-DictContext BuilderContext::StartDict(){
-    return builder_.StartDict();
-}
-Builder& BuilderContext::EndDict(){
-    return builder_.EndDict();
-}
-ArrayContext BuilderContext::StartArray(){
-    return builder_.StartArray();
-}
-Builder& BuilderContext::EndArray(){
-    return builder_.EndArray();
-}
-
 } // namespace json
 
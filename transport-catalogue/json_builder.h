@@ -3,25 +3,26 @@
 #include "json.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace json{
 
-class BuilderContext;
-class KeyContext;
-class KeyValueContext;
-class ArrayContext;
-class DictContext;
-class ArrayValueContext;
+template <typename Backend> class BuilderContext;
+template <typename Backend> class KeyContext;
+template <typename Backend> class KeyValueContext;
+template <typename Backend> class ArrayContext;
+template <typename Backend> class DictContext;
 
 
+// Builds the Node tree. The contexts it returns allow only the calls which keep JSON valid
 class Builder{
 public:
-    KeyContext Key(std:: string key);
+    KeyContext<Builder> Key(std:: string key);
     Builder& Value(Node::Value value);
-    DictContext StartDict();
+    DictContext<Builder> StartDict();
     Builder& EndDict();
-    ArrayContext StartArray();
+    ArrayContext<Builder> StartArray();
     Builder& EndArray();
     Node Build();
 
@@ -35,63 +36,114 @@ private:
 
 
 
+// Contexts are shared by the backends (Builder, Writer), which have the same calls as Builder
+template <typename Backend>
 class BuilderContext{
 public:
-    BuilderContext(Builder& builder)
+    BuilderContext(Backend& builder)
         : builder_(builder){
     }
 
-    KeyContext Key(std::string key);
-    DictContext StartDict();
-    Builder& EndDict();
-    ArrayContext StartArray();
-    Builder& EndArray();
+    template <typename KeyType>
+    KeyContext<Backend> Key(KeyType&& key);
+    DictContext<Backend> StartDict();
+    Backend& EndDict();
+    ArrayContext<Backend> StartArray();
+    Backend& EndArray();
 
 protected:
-    Builder& builder_;
+    Backend& builder_;
 };
 
-class KeyContext final : public BuilderContext {
+template <typename Backend>
+class KeyContext final : public BuilderContext<Backend> {
 public:
-    KeyContext(Builder& builder)
-        : BuilderContext(builder){
+    KeyContext(Backend& builder)
+        : BuilderContext<Backend>(builder){
     }
-    KeyContext Key(std:: string key) = delete;
-    Builder& EndDict() = delete;
-    Builder& EndArray() = delete;
+    template <typename KeyType>
+    KeyContext Key(KeyType&& key) = delete;
+    Backend& EndDict() = delete;
+    Backend& EndArray() = delete;
 
-    KeyValueContext Value(Node::Value value);
+    template <typename ValueType>
+    KeyValueContext<Backend> Value(ValueType&& value);
 };
 
-class KeyValueContext final : public BuilderContext {
+template <typename Backend>
+class KeyValueContext final : public BuilderContext<Backend> {
 public:
-    KeyValueContext(Builder& builder)
-        : BuilderContext(builder){
+    KeyValueContext(Backend& builder)
+        : BuilderContext<Backend>(builder){
     }
-    DictContext StartDict() = delete;
-    ArrayContext StartArray() = delete;
-    Builder& EndArray() = delete;
+    DictContext<Backend> StartDict() = delete;
+    ArrayContext<Backend> StartArray() = delete;
+    Backend& EndArray() = delete;
 };
 
-class DictContext final : public BuilderContext {
+template <typename Backend>
+class DictContext final : public BuilderContext<Backend> {
 public:
-    DictContext(Builder& builder)
-        : BuilderContext(builder){
+    DictContext(Backend& builder)
+        : BuilderContext<Backend>(builder){
     }
     DictContext StartDict() = delete;
-    ArrayContext StartArray() = delete;
-    Builder& EndArray() = delete;
+    ArrayContext<Backend> StartArray() = delete;
+    Backend& EndArray() = delete;
 };
 
-class ArrayContext final : public BuilderContext {
+template <typename Backend>
+class ArrayContext final : public BuilderContext<Backend> {
 public:
-    ArrayContext(Builder& builder)
-        : BuilderContext(builder){
+    ArrayContext(Backend& builder)
+        : BuilderContext<Backend>(builder){
     }
-    KeyContext Key(std:: string key) = delete;
-    Builder& EndDict() = delete;
+    template <typename KeyType>
+    KeyContext<Backend> Key(KeyType&& key) = delete;
+    Backend& EndDict() = delete;
 
-    ArrayContext Value(Node::Value value);
+    template <typename ValueType>
+    ArrayContext Value(ValueType&& value);
 };
 
+template <typename Backend>
+template <typename KeyType>
+KeyContext<Backend> BuilderContext<Backend>::Key(KeyType&& key){
+    return builder_.Key(std::forward<KeyType>(key));
+}
+
+template <typename Backend>
+DictContext<Backend> BuilderContext<Backend>::StartDict(){
+    return builder_.StartDict();
+}
+
+template <typename Backend>
+Backend& BuilderContext<Backend>::EndDict(){
+    return builder_.EndDict();
+}
+
+template <typename Backend>
+ArrayContext<Backend> BuilderContext<Backend>::StartArray(){
+    return builder_.StartArray();
+}
+
+template <typename Backend>
+Backend& BuilderContext<Backend>::EndArray(){
+    return builder_.EndArray();
+}
+
+template <typename Backend>
+template <typename ValueType>
+KeyValueContext<Backend> KeyContext<Backend>::Value(ValueType&& value){
+    this->builder_.Value(std::forward<ValueType>(value));
+    return KeyValueContext<Backend>(this->builder_);
+}
+
+template <typename Backend>
+template <typename ValueType>
+ArrayContext<Backend> ArrayContext<Backend>::Value(ValueType&& value){
+    this->builder_.Value(std::forward<ValueType>(value));
+    return ArrayContext<Backend>(this->builder_);
+}
+
 } // namespace json
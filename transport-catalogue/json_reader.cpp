@@ -3,13 +3,18 @@
 #include "svg.h"
 #include "map_renderer.h"
 #include "json_builder.h"
+#include "json_writer.h"
 #include "graph.h"
-#include "router.h"
 #include "transport_router.h"
 #include "serialization.h"
+#include "ordered_executor.h"
 
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <sstream>
@@ -24,6 +29,620 @@ using TC_Graph = graph::DirectedWeightedGraph<double>;
 namespace tc {
 namespace reader {
 
+namespace {
+
+// Base of the readers which know the layout of the document: a reader handles the parts it knows
+// itself, keeps a part as a node with Capture or throws it away with Skip
+class DocumentReader : public json::Handler {
+protected:
+    ~DocumentReader() = default;
+
+    // Receives the part kept by Capture when its last value is read
+    virtual void OnCaptured(Node node) = 0;
+
+    // Passes the value to the part being kept or skipped, returns false if the reader handles it itself
+    template <typename... Args>
+    bool Divert(void (Handler::*event)(Args...), int depth_change, Args... args){
+        if (skip_depth_ > 0){
+            skip_depth_ += depth_change;
+            return true;
+        }
+        if (!capturing_){
+            return false;
+        }
+        (tree_.*event)(args...);
+        capture_depth_ += depth_change;
+        if (capture_depth_ == 0){
+            capturing_ = false;
+            OnCaptured(tree_.Extract());
+        }
+        return true;
+    }
+
+    // Starts keeping the value which begins with this event
+    template <typename... Args>
+    void Capture(void (Handler::*event)(Args...), int depth_change, Args... args){
+        capturing_ = true;
+        Divert(event, depth_change, args...);
+    }
+
+    // Skips the dict or array which has just started
+    void Skip(){
+        skip_depth_ = 1;
+    }
+
+private:
+    bool capturing_ = false;
+    int capture_depth_ = 0;
+    json::TreeHandler tree_;
+    int skip_depth_ = 0;
+};
+
+// Reads the make_base document: base_requests go to the catalogue as they are read,
+// every other top level section is kept as a node.
+// Distances and buses may name stops described later, so they are kept until base_requests ends
+// and then added the way PerformBaseRequests does: all stops, then distances, then buses.
+class BaseRequestsReader final : public DocumentReader {
+public:
+    explicit BaseRequestsReader(tc::TransportCatalogue& tc)
+        : tc_(tc){
+    }
+
+    // Top level sections except base_requests, null if the document is not a dict
+    Node ExtractRoot(){
+        return is_dict_ ? Node(std::move(sections_)) : Node();
+    }
+
+    void StartDict() override{
+        if (Divert(&Handler::StartDict, 1)){
+            return;
+        }
+        switch (place_){
+            case Place::OUTSIDE:
+                is_dict_ = true;
+                place_ = Place::ROOT;
+                break;
+            case Place::ROOT:
+                Capture(&Handler::StartDict, 1);
+                break;
+            case Place::REQUESTS:
+                request_ = {};
+                place_ = Place::REQUEST;
+                break;
+            case Place::REQUEST:
+                if (BeginField(Kind::DICT) == Field::ROAD_DISTANCES){
+                    place_ = Place::DISTANCES;
+                } else {
+                    Skip();
+                }
+                break;
+            default:
+                SetWrongElement();
+                Skip();
+        }
+    }
+
+    void Key(std::string_view key) override{
+        if (Divert(&Handler::Key, 0, key)){
+            return;
+        }
+        if (place_ == Place::DISTANCES){
+            distance_to_ = key;
+        } else {
+            field_ = key;
+        }
+    }
+
+    void EndDict() override{
+        if (Divert(&Handler::EndDict, -1)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            place_ = Place::OUTSIDE;
+        } else if (place_ == Place::REQUEST){
+            AddRequest();
+            place_ = Place::REQUESTS;
+        } else if (place_ == Place::DISTANCES){
+            place_ = Place::REQUEST;
+        }
+    }
+
+    void StartArray() override{
+        if (Divert(&Handler::StartArray, 1)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            if (field_ != "base_requests"sv){
+                Capture(&Handler::StartArray, 1);
+            } else if (has_requests_){
+                // As in Load, the first of repeated keys is kept
+                Skip();
+            } else {
+                has_requests_ = true;
+                place_ = Place::REQUESTS;
+            }
+        } else if (place_ == Place::REQUEST && BeginField(Kind::ARRAY) == Field::STOPS){
+            place_ = Place::STOPS;
+        } else {
+            SetWrongElement();
+            Skip();
+        }
+    }
+
+    void EndArray() override{
+        if (Divert(&Handler::EndArray, -1)){
+            return;
+        }
+        if (place_ == Place::REQUESTS){
+            AddPendingRequests();
+            place_ = Place::ROOT;
+        } else if (place_ == Place::STOPS){
+            place_ = Place::REQUEST;
+        }
+    }
+
+    void String(std::string_view value) override{
+        if (Divert(&Handler::String, 0, value)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            Capture(&Handler::String, 0, value);
+        } else if (place_ == Place::REQUEST){
+            const auto field = BeginField(Kind::STRING);
+            if (field == Field::TYPE){
+                request_.type = value;
+            } else if (field == Field::NAME){
+                request_.name = value;
+            }
+        } else if (place_ == Place::STOPS){
+            request_.stops.emplace_back(value);
+        } else {
+            SetWrongElement();
+        }
+    }
+
+    void Int(int value) override{
+        if (Divert(&Handler::Int, 0, value)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            Capture(&Handler::Int, 0, value);
+        } else if (place_ == Place::DISTANCES){
+            request_.distances.emplace_back(distance_to_, value);
+        } else if (place_ == Place::REQUEST){
+            SetCoordinate(value);
+        } else {
+            SetWrongElement();
+        }
+    }
+
+    void Double(double value) override{
+        if (Divert(&Handler::Double, 0, value)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            Capture(&Handler::Double, 0, value);
+        } else if (place_ == Place::REQUEST){
+            SetCoordinate(value);
+        } else {
+            SetWrongElement();
+        }
+    }
+
+    void Bool(bool value) override{
+        if (Divert(&Handler::Bool, 0, value)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            Capture(&Handler::Bool, 0, value);
+        } else if (place_ == Place::REQUEST){
+            if (BeginField(Kind::BOOL) == Field::IS_ROUNDTRIP){
+                request_.is_roundtrip = value;
+            }
+        } else {
+            SetWrongElement();
+        }
+    }
+
+    void Null() override{
+        if (Divert(&Handler::Null, 0)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            Capture(&Handler::Null, 0);
+        } else if (place_ == Place::REQUEST){
+            BeginField(Kind::NULL_VALUE);
+        } else {
+            SetWrongElement();
+        }
+    }
+
+private:
+    // Where the next value is: OUTSIDE is before and after the document,
+    // REQUEST is one element of base_requests, DISTANCES and STOPS are its fields
+    enum class Place{ OUTSIDE, ROOT, REQUESTS, REQUEST, DISTANCES, STOPS };
+
+    // Fields of a request PerformBaseRequests reads. It throws when a field it needs is missing
+    // or has a wrong type, and so does this reader
+    enum class Field{ TYPE, NAME, LATITUDE, LONGITUDE, ROAD_DISTANCES, STOPS, IS_ROUNDTRIP };
+    static constexpr size_t FIELD_COUNT = 7;
+    static constexpr std::string_view FIELD_NAMES[FIELD_COUNT] = {
+        "type"sv, "name"sv, "latitude"sv, "longitude"sv, "road_distances"sv, "stops"sv, "is_roundtrip"sv};
+
+    // JSON type of a value, NUMBER is int or double as AsDouble takes both
+    enum class Kind{ STRING, NUMBER, BOOL, DICT, ARRAY, NULL_VALUE };
+    static constexpr Kind FIELD_KINDS[FIELD_COUNT] = {
+        Kind::STRING, Kind::STRING, Kind::NUMBER, Kind::NUMBER, Kind::DICT, Kind::ARRAY, Kind::BOOL};
+
+    struct Request{
+        std::string type;
+        std::string name;
+        double latitude = 0;
+        double longitude = 0;
+        std::vector<std::pair<std::string, int>> distances;
+        std::vector<std::string> stops;
+        bool is_roundtrip = false;
+        // As in Load, only the first of repeated keys counts
+        std::array<bool, FIELD_COUNT> is_seen{};
+        // The value has the type AsString, AsDouble... expect, for containers every element too
+        std::array<bool, FIELD_COUNT> is_valid{};
+    };
+
+    tc::TransportCatalogue& tc_;
+    Place place_ = Place::OUTSIDE;
+    bool is_dict_ = false;
+    bool has_requests_ = false;
+    std::string field_;
+    std::string distance_to_;
+    Request request_;
+    std::vector<Request> pending_distances_;
+    std::vector<Request> pending_buses_;
+    Dict sections_;
+
+    void OnCaptured(Node node) override{
+        sections_.emplace(field_, std::move(node));
+    }
+
+    // Notes the value of the current request field. Returns the field if the value is to be read:
+    // the key is known, met for the first time and the value has the right type
+    std::optional<Field> BeginField(Kind kind){
+        const auto name = std::find(std::begin(FIELD_NAMES), std::end(FIELD_NAMES), field_);
+        if (name == std::end(FIELD_NAMES)){
+            return std::nullopt;
+        }
+        const size_t index = static_cast<size_t>(name - std::begin(FIELD_NAMES));
+        if (request_.is_seen[index]){
+            return std::nullopt;
+        }
+        request_.is_seen[index] = true;
+        request_.is_valid[index] = kind == FIELD_KINDS[index];
+        return request_.is_valid[index] ? std::optional(static_cast<Field>(index)) : std::nullopt;
+    }
+
+    // A value which is not a request in base_requests, or a wrong element of road_distances or stops
+    void SetWrongElement(){
+        if (place_ == Place::REQUESTS){
+            throw std::logic_error("base_requests element is not a dict"s);
+        } else if (place_ == Place::DISTANCES){
+            request_.is_valid[static_cast<size_t>(Field::ROAD_DISTANCES)] = false;
+        } else if (place_ == Place::STOPS){
+            request_.is_valid[static_cast<size_t>(Field::STOPS)] = false;
+        }
+    }
+
+    void SetCoordinate(double value){
+        const auto field = BeginField(Kind::NUMBER);
+        if (field == Field::LATITUDE){
+            request_.latitude = value;
+        } else if (field == Field::LONGITUDE){
+            request_.longitude = value;
+        }
+    }
+
+    // Throws as at() and As...() do in PerformBaseRequests
+    void Require(Field field) const{
+        const size_t index = static_cast<size_t>(field);
+        if (!request_.is_seen[index]){
+            throw std::out_of_range("base request has no "s + std::string(FIELD_NAMES[index]));
+        }
+        if (!request_.is_valid[index]){
+            throw std::logic_error("base request has a wrong "s + std::string(FIELD_NAMES[index]));
+        }
+    }
+
+    void AddRequest(){
+        Require(Field::TYPE);
+        if (request_.type == "Stop"sv){
+            Require(Field::NAME);
+            Require(Field::LATITUDE);
+            Require(Field::LONGITUDE);
+            tc_.AddStop(request_.name, request_.latitude, request_.longitude);
+            if (!request_.is_seen[static_cast<size_t>(Field::ROAD_DISTANCES)]){
+                return;
+            }
+            Require(Field::ROAD_DISTANCES);
+            // As in Load, the first of repeated stops is kept
+            auto& distances = request_.distances;
+            std::stable_sort(distances.begin(), distances.end(), [](const auto& lhs, const auto& rhs){
+                return lhs.first < rhs.first; });
+            distances.erase(std::unique(distances.begin(), distances.end(), [](const auto& lhs, const auto& rhs){
+                return lhs.first == rhs.first; }), distances.end());
+            if (!distances.empty()){
+                pending_distances_.push_back(std::move(request_));
+            }
+        } else if (request_.type == "Bus"sv){
+            Require(Field::NAME);
+            Require(Field::STOPS);
+            Require(Field::IS_ROUNDTRIP);
+            pending_buses_.push_back(std::move(request_));
+        }
+    }
+
+    void AddPendingRequests(){
+        for (const auto& request : pending_distances_){
+            for (const auto& [stop_name, distance] : request.distances){
+                tc_.SetDistance(request.name, stop_name, distance);
+            }
+        }
+        pending_distances_.clear();
+
+        vector<string_view> stops_for_bus;
+        for (const auto& request : pending_buses_){
+            stops_for_bus.assign(request.stops.begin(), request.stops.end());
+            tc_.AddBus(request.name, stops_for_bus, request.is_roundtrip);
+        }
+        pending_buses_.clear();
+
+        tc_.Finalize();
+    }
+};
+
+// Writes the array of answers to stat requests, every answer as soon as it and all the previous ones are ready.
+// With more than one thread the answers are made by an OrderedExecutor, each into its own buffer,
+// and the output is the same as with one thread.
+class AnswersWriter{
+public:
+    AnswersWriter(std::ostream& output, size_t thread_count)
+        : output_(output)
+        , writer_(output){
+        writer_.StartArray();
+        if (thread_count > 1){
+            executor_.emplace(thread_count, [this](std::string_view answer){
+                writer_.RawValue(answer).Flush();
+                output_.flush();
+            });
+        }
+    }
+
+    // The catalogue, renderer and router have to live until Close
+    void Answer(const tc::TransportCatalogue& tc, const MapRenderer& mr, const tc::router::Router& router, Node request){
+        if (!executor_){
+            handler::GetStatAnswer(tc, request.AsDict(), mr, writer_, router);
+            writer_.Flush();
+            output_.flush();
+            return;
+        }
+        executor_->Submit([&tc, &mr, &router, request = std::move(request)](){
+            std::ostringstream answer;
+            // Indented as an element of the answers array
+            Writer writer(answer, Writer::Layout::INDENTED, 1);
+            handler::GetStatAnswer(tc, request.AsDict(), mr, writer, router);
+            writer.Flush();
+            return answer.str();
+        });
+    }
+
+    void Close(){
+        if (executor_){
+            executor_->Finish();
+        }
+        writer_.EndArray().Flush();
+        output_ << endl;
+    }
+
+private:
+    std::ostream& output_;
+    Writer writer_;
+    // Declared last, its workers use the writer until it is destroyed
+    std::optional<parallel::OrderedExecutor> executor_;
+};
+
+// Reads the process_requests document and answers every stat request as soon as it is read.
+// The input is read in chunks, and with one thread only one request and its answer are kept at a time,
+// with more the AnswersWriter holds up to 256 requests or answers per thread.
+// The base is loaded when serialization_settings is read: requests met before it are kept until then,
+// so memory grows with their number, and without it the base is loaded from an empty file name
+// at the end of the document.
+class StatRequestsReader final : public DocumentReader {
+public:
+    StatRequestsReader(std::ostream& output, const StateLoader& load_state, size_t thread_count)
+        : output_(output)
+        , thread_count_(thread_count)
+        , load_state_(load_state){
+    }
+
+    void StartDict() override{
+        if (Divert(&Handler::StartDict, 1)){
+            return;
+        }
+        if (place_ == Place::OUTSIDE){
+            place_ = Place::ROOT;
+        } else if (place_ == Place::REQUESTS || (place_ == Place::ROOT && field_ == "serialization_settings"sv && !state_)){
+            Capture(&Handler::StartDict, 1);
+        } else {
+            Skip();
+        }
+    }
+
+    void Key(std::string_view key) override{
+        if (!Divert(&Handler::Key, 0, key)){
+            field_ = key;
+        }
+    }
+
+    void EndDict() override{
+        if (Divert(&Handler::EndDict, -1)){
+            return;
+        }
+        if (place_ == Place::ROOT){
+            place_ = Place::OUTSIDE;
+            if (has_requests_ && !state_){
+                LoadState({});
+            }
+        }
+    }
+
+    void StartArray() override{
+        if (Divert(&Handler::StartArray, 1)){
+            return;
+        }
+        if (place_ == Place::ROOT && field_ == "stat_requests"sv && !has_requests_){
+            has_requests_ = true;
+            answers_.emplace(output_, thread_count_);
+            place_ = Place::REQUESTS;
+        } else {
+            Skip();
+        }
+    }
+
+    void EndArray() override{
+        if (Divert(&Handler::EndArray, -1)){
+            return;
+        }
+        if (place_ == Place::REQUESTS){
+            requests_ended_ = true;
+            place_ = Place::ROOT;
+            if (state_){
+                CloseAnswers();
+            }
+        }
+    }
+
+    void String(std::string_view value) override{
+        Divert(&Handler::String, 0, value);
+    }
+
+    void Int(int value) override{
+        Divert(&Handler::Int, 0, value);
+    }
+
+    void Double(double value) override{
+        Divert(&Handler::Double, 0, value);
+    }
+
+    void Bool(bool value) override{
+        Divert(&Handler::Bool, 0, value);
+    }
+
+    void Null() override{
+        Divert(&Handler::Null, 0);
+    }
+
+private:
+    enum class Place{ OUTSIDE, ROOT, REQUESTS };
+
+    std::ostream& output_;
+    const size_t thread_count_;
+    const StateLoader& load_state_;
+    Place place_ = Place::OUTSIDE;
+    std::string field_;
+    tc::service::StatePtr state_;
+    bool has_requests_ = false;
+    bool requests_ended_ = false;
+    std::vector<Node> pending_requests_;
+    // Declared after state_, the answers being made use it
+    std::optional<AnswersWriter> answers_;
+
+    void OnCaptured(Node node) override{
+        if (place_ == Place::REQUESTS){
+            if (state_){
+                Answer(std::move(node));
+            } else {
+                pending_requests_.push_back(std::move(node));
+            }
+        } else {
+            LoadState(node.AsDict().at("file"s).AsString());
+        }
+    }
+
+    void LoadState(const std::string& filename){
+        state_ = load_state_(filename);
+        for (auto& request : pending_requests_){
+            Answer(std::move(request));
+        }
+        pending_requests_.clear();
+        if (requests_ended_){
+            CloseAnswers();
+        }
+    }
+
+    void Answer(Node request){
+        answers_->Answer(*state_->catalogue, state_->renderer, *state_->router, std::move(request));
+    }
+
+    void CloseAnswers(){
+        answers_->Close();
+    }
+};
+
+// One line answer to one request of a JSON Lines stream
+string AnswerLineRequest(tc::service::StateHandle& handle, const string& base_filename,
+                         const tc::service::ServiceState& state, const Node& request){
+    ostringstream output;
+    try {
+        Writer writer(output, Writer::Layout::ONE_LINE);
+        const Dict& dict = request.AsDict();
+        if (dict.count("type"sv) != 0 && dict.at("type"sv).AsString() == "Reload"sv){
+            writer.StartDict();
+            if (dict.count("id"sv) != 0){
+                writer.Key("request_id"sv).Value(dict.at("id"sv).AsInt());
+            }
+            // Clients must not make the server open other files
+            if (dict.count("file"sv) != 0 && dict.at("file"sv).AsString() != base_filename){
+                writer.Key("error_message"sv).Value("only the served base can be reloaded"sv);
+            } else {
+                // Loaded in the background, requests are answered from the current base until it is published
+                handle.ReloadAsync(base_filename);
+                writer.Key("status"sv).Value("loading"sv);
+            }
+            writer.EndDict();
+        } else {
+            handler::GetStatAnswer(*state.catalogue, dict, state.renderer, writer, *state.router);
+        }
+        writer.Flush();
+    } catch (const exception&) {
+        // The Writer passes nothing to the output before Flush, so a failed answer left no text
+        Writer writer(output, Writer::Layout::ONE_LINE);
+        writer.StartDict();
+        if (request.IsDict() && request.AsDict().count("id"sv) != 0 && request.AsDict().at("id"sv).IsInt()){
+            writer.Key("request_id"sv).Value(request.AsDict().at("id"sv).AsInt());
+        }
+        writer.Key("error_message"sv).Value("bad request"sv).EndDict();
+        writer.Flush();
+    }
+    return output.str();
+}
+
+// One line answer to a request or an array of them
+string AnswerLineRequests(tc::service::StateHandle& handle, const string& base_filename, const Node& requests){
+    // Taken once, so a batch is answered from one state even if a base is reloaded meanwhile
+    const tc::service::StatePtr state = handle.Acquire();
+    if (!requests.IsArray()){
+        return AnswerLineRequest(handle, base_filename, *state, requests);
+    }
+    string answers = "["s;
+    for (const Node& request : requests.AsArray()){
+        if (answers.size() > 1){
+            answers += ',';
+        }
+        answers += AnswerLineRequest(handle, base_filename, *state, request);
+    }
+    answers += ']';
+    return answers;
+}
+
+} // namespace
+
 void ReadJSON(tc::TransportCatalogue& tc, istream& input){
     Node main_node = Load(input).GetRoot();
     if (!main_node.IsDict()){
@@ -42,6 +661,27 @@ json::Node LoadJSON(istream& input){
     return Load(input).GetRoot();
 }
 
+json::Node LoadBaseFromJSON(tc::TransportCatalogue& tc, istream& input){
+    BaseRequestsReader reader(tc);
+    json::Parse(input, reader);
+    return reader.ExtractRoot();
+}
+
+void AnswerStatRequestsFromJSON(istream& input, ostream& output, const StateLoader& load_state, size_t thread_count){
+    StatRequestsReader reader(output, load_state, thread_count);
+    json::Parse(input, reader);
+}
+
+string AnswerStatRequestLine(tc::service::StateHandle& handle, const string& base_filename, string_view line){
+    // Every request is answered even if it fails, so a ParsingError can come only from Load
+    try {
+        const Document document = Load(line);
+        return AnswerLineRequests(handle, base_filename, document.GetRoot());
+    } catch (const ParsingError&) {
+        return "{\"error_message\":\"bad json\"}"s;
+    }
+}
+
 bool MakeBaseFromJSON(tc::TransportCatalogue& tc, tc::renderer::RenderSettings& render_s,
                       tc::router::RoutingSettings& routing_s, const json::Node& main_node){
     if (!main_node.IsDict()){
@@ -54,13 +694,9 @@ bool MakeBaseFromJSON(tc::TransportCatalogue& tc, tc::renderer::RenderSettings&
     return true;
 }
 
-bool ProcessRequestFromJSON(const tc::TransportCatalogue& tc, const tc::renderer::RenderSettings& render_s,
-                            const tc::router::RoutingSettings& routing_s, const json::Node& main_node){
+bool ProcessRequestFromJSON(const tc::service::ServiceState& state, const json::Node& main_node){
     if (main_node.IsDict()){
-
-        MapRenderer map_renderer(render_s);
-        tc::router::Router router(routing_s, tc);
-        handler::PerformStatRequests(tc, main_node.AsDict(), map_renderer, router);
+        handler::PerformStatRequests(*state.catalogue, main_node.AsDict(), state.renderer, *state.router);
         return true;
     }
     return false;
@@ -94,6 +730,9 @@ RenderSettings ReadRenderSettingsFromJSON(const Dict& db){
     for(const auto& color : settings.at("color_palette"s).AsArray()){
         render_setting.color_palette.push_back(ReadSVGColorFromJSON(color));
     }
+    if (settings.count("coordinate_precision"s) != 0){
+        render_setting.coordinate_precision = settings.at("coordinate_precision"s).AsInt();
+    }
     return render_setting;
 }
 
@@ -145,6 +784,8 @@ void PerformBaseRequests(tc::TransportCatalogue& tc, const Dict& db){
     for (const auto& request : requests.AsArray()){
         AddBus(tc, request.AsDict());
     }
+
+    tc.Finalize();
 }
 
 void AddStop(tc::TransportCatalogue& tc, const Dict& request){
@@ -169,22 +810,11 @@ void AddBus(tc::TransportCatalogue& tc, const Dict& request){
     bool is_roundtrip = request.at("is_roundtrip"s).AsBool();
 
     vector<string_view> stops_for_bus;
-    if(is_roundtrip){
-        stops_for_bus.reserve(stops.size());
-    } else{
-        stops_for_bus.reserve(stops.size() * 2 - 1);
-    }
-
+    stops_for_bus.reserve(stops.size());
     for (const auto& stop_node : stops){
         stops_for_bus.push_back(stop_node.AsString());
     }
 
-    if (!is_roundtrip){
-        for(auto it = stops.rbegin() + 1; it < stops.rend(); ++it){
-            stops_for_bus.push_back((*it).AsString());
-        }
-    }
-
     tc.AddBus(request.at("name"s).AsString(), stops_for_bus, is_roundtrip);
 }
 
@@ -195,44 +825,37 @@ tc::router::RoutingSettings PerformRoutingSettings(const Dict& db){
     }
 
     Dict settings = db.at("routing_settings"s).AsDict();
-    return {settings.at("bus_wait_time"s).AsInt(), settings.at("bus_velocity"s).AsDouble()};
+    tc::router::RoutingSettings routing_settings{settings.at("bus_wait_time"s).AsInt(), settings.at("bus_velocity"s).AsDouble()};
+    if (settings.count("landmark_count"s) != 0){
+        routing_settings.landmark_count = settings.at("landmark_count"s).AsInt();
+    }
+    if (settings.count("pareto_label_limit"s) != 0){
+        routing_settings.pareto_label_limit = settings.at("pareto_label_limit"s).AsInt();
+    }
+    return routing_settings;
 }
 
 // Stat Request
-void PerformStatRequests(const tc::TransportCatalogue& tc, const Dict& db, const renderer::MapRenderer& mr, const tc::router::Router& router){
+void PerformStatRequests(const tc::TransportCatalogue& tc, const Dict& db, const renderer::MapRenderer& mr, const tc::router::Router& router,
+                         size_t thread_count){
 
     if (db.count("stat_requests"s) == 0){
         return;
     }
 
-    Node requests = db.at("stat_requests"s);
-
-    Array stat;
-    stat.reserve(requests.AsArray().size());
-
-    auto builderJSON = json::Builder{};
-    builderJSON.StartArray();
-    for (const auto& request : requests.AsArray()){
-        GetStatAnswer(tc, request.AsDict(), mr, builderJSON, router);
-    }
-
-    json::Print(
-        json::Document{
-            builderJSON
-            .EndArray()
-            .Build()
-        },
-        cout
-      );
-      cout << endl;
+    AnswersWriter answers(cout, thread_count);
+    for (const auto& request : db.at("stat_requests"s).AsArray()){
+        answers.Answer(tc, mr, router, request);
+    }
+    answers.Close();
 }
 
-void GetStatAnswer(const tc::TransportCatalogue& tc, const Dict& request, const renderer::MapRenderer& mr, Builder& bjson, const tc::router::Router& router){
+void GetStatAnswer(const tc::TransportCatalogue& tc, const Dict& request, const renderer::MapRenderer& mr, Writer& bjson, const tc::router::Router& router){
 //    cerr << "GetStatAnswer" << endl;
     bjson.StartDict().Key("request_id"s).Value(request.at("id").AsInt());
 
     if (request.at("type").AsString() == "Bus"s){
-        tc::RouteStatistics stat = tc.GetStatistics(request.at("name").AsString());
+        const tc::RouteStatistics& stat = tc.GetStatistics(request.at("name").AsString());
         if (stat.stops == 0){
             bjson.Key("error_message"s).Value("not found"s).EndDict();
             return;
@@ -245,7 +868,7 @@ void GetStatAnswer(const tc::TransportCatalogue& tc, const Dict& request, const
             bjson.Key("error_message"s).Value("not found"s).EndDict();
             return;
         }
-        StopRequestToDictConvertion(bjson, stop);
+        StopRequestToDictConvertion(bjson, stop, tc);
 
     } else if (request.at("type").AsString() == "Map"s){
         std::ostringstream str_stream;
@@ -255,45 +878,101 @@ void GetStatAnswer(const tc::TransportCatalogue& tc, const Dict& request, const
         string stop_from = request.at("from"s).AsString();
         string stop_to = request.at("to"s).AsString();
 
+        if (request.count("alternatives"s) != 0){
+            auto routes = router.FindAlternativeRoutes(stop_from, stop_to, static_cast<size_t>(std::max(request.at("alternatives"s).AsInt(), 0)));
+            if (routes.empty()){
+                bjson.Key("error_message"s).Value("not found"s).EndDict();
+                return;
+            }
+            bjson.Key("routes"s).StartArray();
+            for (const auto& route : routes){
+                bjson.StartDict();
+                RouteInfoToDictConvertion(bjson, route, router);
+                bjson.EndDict();
+            }
+            bjson.EndArray().EndDict();
+            return;
+        }
+
         auto route = router.FindRoute(stop_from, stop_to);
 
         if (!route){
             bjson.Key("error_message"s).Value("not found"s).EndDict();
             return;
         }
-        bjson.Key("items"s).StartArray();
-        for (const auto& edge_id : route.value().edges){
-            tc::router::EdgeInfo edge_info = router.GetEdgeInfo(edge_id);
+        RouteInfoToDictConvertion(bjson, route.value(), router);
+
+    } else if (request.at("type").AsString() == "Nearby"s){
+        const geo::Coordinates center{request.at("lat"s).AsDouble(), request.at("lng"s).AsDouble()};
+        NearbyStopsToDictConvertion(bjson, tc.FindStopsNearby(center, request.at("radius"s).AsDouble()), tc);
+
+    } else if (request.at("type").AsString() == "NearestStops"s){
+        const geo::Coordinates center{request.at("lat"s).AsDouble(), request.at("lng"s).AsDouble()};
+        const size_t count = static_cast<size_t>(std::max(request.at("count"s).AsInt(), 0));
+        NearbyStopsToDictConvertion(bjson, tc.FindNearestStops(center, count), tc);
+
+    } else if (request.at("type").AsString() == "ParetoRoute"s){
+        auto routes = router.FindParetoRoutes(request.at("from"s).AsString(), request.at("to"s).AsString());
+
+        if (routes.empty()){
+            bjson.Key("error_message"s).Value("not found"s).EndDict();
+            return;
+        }
+        bjson.Key("routes"s).StartArray();
+        for (const auto& pareto_route : routes){
             bjson.StartDict();
-            if (edge_info.type == EdgeType::WAIT){
-                bjson.Key("type"s).Value("Wait"s);
-                bjson.Key("stop_name"s).Value(string(edge_info.name));
-            } else if (edge_info.type == EdgeType::BUS){
-                bjson.Key("type"s).Value("Bus"s);
-                bjson.Key("bus"s).Value(string(edge_info.name));
-                bjson.Key("span_count"s).Value(edge_info.span_count.value());
-            }
-            bjson.Key("time"s).Value((router.GetEdge(edge_id)).weight);
+            bjson.Key("transfers"s).Value(pareto_route.transfers);
+            RouteInfoToDictConvertion(bjson, pareto_route.route, router);
             bjson.EndDict();
         }
         bjson.EndArray();
-
-        bjson.Key("total_time"s).Value(route.value().weight);
     }
     bjson.EndDict();
 }
 
-void RouteStatisticsToDictConvertion(Builder& bjson, const tc::RouteStatistics& stat){
+void RouteInfoToDictConvertion(Writer& bjson, const tc::router::RouteInfo& route, const tc::router::Router& router){
+    bjson.Key("items"s).StartArray();
+    for (const auto& edge_id : route.edges){
+        tc::router::EdgeInfo edge_info = router.GetEdgeInfo(edge_id);
+        bjson.StartDict();
+        if (edge_info.type == EdgeType::WAIT){
+            bjson.Key("type"s).Value("Wait"s);
+            bjson.Key("stop_name"s).Value(string(edge_info.name));
+        } else if (edge_info.type == EdgeType::BUS){
+            bjson.Key("type"s).Value("Bus"s);
+            bjson.Key("bus"s).Value(string(edge_info.name));
+            bjson.Key("span_count"s).Value(edge_info.span_count.value());
+        }
+        bjson.Key("time"s).Value((router.GetEdge(edge_id)).weight);
+        bjson.EndDict();
+    }
+    bjson.EndArray();
+
+    bjson.Key("total_time"s).Value(route.weight);
+}
+
+void RouteStatisticsToDictConvertion(Writer& bjson, const tc::RouteStatistics& stat){
     bjson.Key("stop_count"s).Value(static_cast<int>(stat.stops));
     bjson.Key("unique_stop_count"s).Value(static_cast<int>(stat.unique_stops));
     bjson.Key("route_length"s).Value(stat.route_length);
     bjson.Key("curvature"s).Value(stat.curvature);
 }
 
-void StopRequestToDictConvertion(Builder& bjson, const tc::StopRequest& stop){
+void StopRequestToDictConvertion(Writer& bjson, const tc::StopRequest& stop, const tc::TransportCatalogue& tc){
     bjson.Key("buses"s).StartArray();
-    for (const auto& bus : stop.all_buses){
-        bjson.Value(string(bus));
+    for (const auto bus_id : stop.all_buses){
+        bjson.Value(string(tc.GetBusName(bus_id)));
+    }
+    bjson.EndArray();
+}
+
+void NearbyStopsToDictConvertion(Writer& bjson, const std::vector<tc::NearbyStop>& stops, const tc::TransportCatalogue& tc){
+    bjson.Key("stops"s).StartArray();
+    for (const auto& stop : stops){
+        bjson.StartDict()
+                .Key("name"s).Value(string(tc.GetStopName(stop.stop_id)))
+                .Key("distance"s).Value(stop.distance)
+             .EndDict();
     }
     bjson.EndArray();
 }
@@ -2,15 +2,16 @@
 
 #include "json.h"
 #include "json_builder.h"
+#include "json_writer.h"
 #include "svg.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "graph.h"
-#include "router.h"
 #include "transport_router.h"
-#include "router.h"
 #include "serialization.h"
+#include "catalogue_service.h"
 
+#include <functional>
 #include <string>
 
 namespace tc {
@@ -18,6 +19,25 @@ namespace reader {
 
 void ReadJSON(tc::TransportCatalogue& tc, std::istream& input = std::cin);
 json::Node LoadJSON(std::istream& input);
+// Adds base_requests to the catalogue while the input is parsed and finalizes it,
+// returns the other top level sections to be read with MakeBaseFromJSON
+json::Node LoadBaseFromJSON(tc::TransportCatalogue& tc, std::istream& input);
+
+// Gives the state to answer stat requests from, by the file name of serialization_settings
+using StateLoader = std::function<tc::service::StatePtr(const std::string& filename)>;
+// Answers stat_requests while the input is parsed, every answer is printed as soon as it is ready,
+// the output is the same as PerformStatRequests gives. With thread_count > 1 requests are answered in parallel,
+// the output stays the same.
+void AnswerStatRequestsFromJSON(std::istream& input, std::ostream& output, const StateLoader& load_state,
+                                size_t thread_count = 1);
+// Answers one line of JSON Lines input with one line (without the line break): a stat request gives its answer,
+// an array of them gives the array of answers, all from one state. {"id": ..., "type": "Reload"} starts loading
+// base_filename again in the background (e.g. after make_base rewrote it) and answers "status": "loading" at once,
+// later requests are answered from it when it is loaded (a base that can not be read is reported to stderr
+// and the current one stays). A "file" other than base_filename is refused, clients can not make the server
+// open other files. A request that can not be answered gets "error_message".
+std::string AnswerStatRequestLine(tc::service::StateHandle& state, const std::string& base_filename,
+                                  std::string_view line);
 
 renderer::RenderSettings ReadRenderSettingsFromJSON(const json::Dict& db);
 svg::Color ReadSVGColorFromJSON(const json::Node& from_color);
@@ -26,14 +46,13 @@ std::string ReadSerializationSettingsFromJSON(const json::Node& main_node);
 bool MakeBaseFromJSON(tc::TransportCatalogue& tc, tc::renderer::RenderSettings& render_s,
                       tc::router::RoutingSettings& routing_s, const json::Node& main_node);
 
-bool ProcessRequestFromJSON(const tc::TransportCatalogue& tc, const tc::renderer::RenderSettings& render_s,
-                            const tc::router::RoutingSettings& routing_s, const json::Node& main_node);
+bool ProcessRequestFromJSON(const tc::service::ServiceState& state, const json::Node& main_node);
 
 namespace handler {
 
 void PerformBaseRequests(tc::TransportCatalogue& tc, const json::Dict& db);
 void PerformStatRequests(const tc::TransportCatalogue& tc, const json::Dict& db,
-                         const renderer::MapRenderer& mr, const tc::router::Router& router);
+                         const renderer::MapRenderer& mr, const tc::router::Router& router, size_t thread_count = 1);
 
 //  BaseRequest Handlers
 void AddStop(tc::TransportCatalogue& tc, const json::Dict& request);
@@ -44,11 +63,13 @@ void AddBus(tc::TransportCatalogue& tc, const json::Dict& request);
 tc::router::RoutingSettings PerformRoutingSettings(const json::Dict& db);
 
 //  StatRequest Handlers
-void GetStatAnswer(const tc::TransportCatalogue& tc, const json::Dict& request, const renderer::MapRenderer& render_settings, json::Builder& bjson,
+void GetStatAnswer(const tc::TransportCatalogue& tc, const json::Dict& request, const renderer::MapRenderer& render_settings, json::Writer& bjson,
                    const tc::router::Router& router);
 
-void RouteStatisticsToDictConvertion(json::Builder& bjson, const tc::RouteStatistics& stat);
-void StopRequestToDictConvertion(json::Builder& bjson, const tc::StopRequest& stop);
+void RouteStatisticsToDictConvertion(json::Writer& bjson, const tc::RouteStatistics& stat);
+void StopRequestToDictConvertion(json::Writer& bjson, const tc::StopRequest& stop, const tc::TransportCatalogue& tc);
+void RouteInfoToDictConvertion(json::Writer& bjson, const tc::router::RouteInfo& route, const tc::router::Router& router);
+void NearbyStopsToDictConvertion(json::Writer& bjson, const std::vector<tc::NearbyStop>& stops, const tc::TransportCatalogue& tc);
 std::ostringstream& MapRequest(std::ostringstream& str_stream, const tc::TransportCatalogue& tc, const renderer::MapRenderer& render_settings);
 
 //  Render
@@ -0,0 +1,212 @@
+#include "json_writer.h"
+#include "char_scan.h"
+#include "number_format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+using namespace std;
+
+namespace json{
+
+Writer::Writer(ostream& output, Layout layout, size_t depth)
+    : output_(output)
+    , indented_(layout == Layout::INDENTED)
+    , depth_(depth){
+}
+
+KeyContext<Writer> Writer::Key(string_view key){
+    if (frames_.empty() || !frames_.back().is_dict || expects_value_){
+        throw std::logic_error("error Key(string_view key) : the last opened value is not json::Dict"s);
+    }
+    Frame& frame = frames_.back();
+    if (!frame.is_empty){
+        WriteSeparator();
+    }
+    frame.is_empty = false;
+    members_.push_back({string(key), buffer_.size(), buffer_.size()});
+    WriteIndent(frames_.size());
+    WriteString(key);
+    buffer_ += indented_ ? ": "sv : ":"sv;
+    expects_value_ = true;
+    return *this;
+}
+
+Writer& Writer::Value(string_view value){
+    BeginValue();
+    WriteString(value);
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(const char* value){
+    return Value(string_view(value));
+}
+
+Writer& Writer::Value(int value){
+    BeginValue();
+    char str[16];
+    buffer_.append(str, to_chars(begin(str), end(str), value).ptr);
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(double value){
+    BeginValue();
+    char str[number_format::MAX_DOUBLE_SIZE];
+    buffer_.append(str, number_format::WriteDouble(begin(str), end(str), value));
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(bool value){
+    BeginValue();
+    buffer_ += value ? "true"sv : "false"sv;
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(nullptr_t){
+    BeginValue();
+    buffer_ += "null"sv;
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::RawValue(string_view text){
+    BeginValue();
+    buffer_ += text;
+    EndValue();
+    return *this;
+}
+
+DictContext<Writer> Writer::StartDict(){
+    OpenFrame(true, '{');
+    return *this;
+}
+
+Writer& Writer::EndDict(){
+    CloseFrame(true, '}');
+    return *this;
+}
+
+ArrayContext<Writer> Writer::StartArray(){
+    OpenFrame(false, '[');
+    return *this;
+}
+
+Writer& Writer::EndArray(){
+    CloseFrame(false, ']');
+    return *this;
+}
+
+void Writer::Flush(){
+    if (any_of(frames_.begin(), frames_.end(), [](const Frame& frame){ return frame.is_dict; })){
+        throw std::logic_error("error Flush() : a json::Dict is opened"s);
+    }
+    output_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::BeginValue(){
+    if (frames_.empty()){
+        return;
+    }
+    Frame& frame = frames_.back();
+    if (frame.is_dict){
+        if (!expects_value_){
+            throw std::logic_error("error Value() : Key() is expected in json::Dict"s);
+        }
+        return;
+    }
+    if (!frame.is_empty){
+        WriteSeparator();
+    }
+    frame.is_empty = false;
+    WriteIndent(frames_.size());
+}
+
+void Writer::EndValue(){
+    if (!frames_.empty() && frames_.back().is_dict){
+        members_.back().end = buffer_.size();
+        expects_value_ = false;
+    }
+}
+
+void Writer::OpenFrame(bool is_dict, char bracket){
+    BeginValue();
+    buffer_ += bracket;
+    if (indented_){
+        buffer_ += '\n';
+    }
+    frames_.push_back({is_dict, members_.size(), buffer_.size()});
+    expects_value_ = false;
+}
+
+void Writer::CloseFrame(bool is_dict, char bracket){
+    if (frames_.empty() || frames_.back().is_dict != is_dict || expects_value_){
+        throw std::logic_error(is_dict ? "error EndDict() : the last opened value is not json::Dict"s
+                                       : "error EndArray() : the last opened value is not json::Array"s);
+    }
+    const Frame frame = frames_.back();
+    if (is_dict){
+        SortMembers(frame);
+        members_.resize(frame.first_member);
+    }
+    frames_.pop_back();
+    if (indented_){
+        buffer_ += '\n';
+        WriteIndent(frames_.size());
+    }
+    buffer_ += bracket;
+    EndValue();
+}
+
+// Reorders the members of the dict in its text, as Dict orders them
+void Writer::SortMembers(const Frame& frame){
+    const auto first = members_.begin() + static_cast<ptrdiff_t>(frame.first_member);
+    const auto by_key = [](const Member& lhs, const Member& rhs){ return lhs.key < rhs.key; };
+    if (is_sorted(first, members_.end(), by_key)){
+        return;
+    }
+    reorder_buffer_.assign(buffer_, frame.text_begin, string::npos);
+    stable_sort(first, members_.end(), by_key);
+    buffer_.resize(frame.text_begin);
+    for (auto it = first; it != members_.end(); ++it){
+        if (it != first){
+            WriteSeparator();
+        }
+        buffer_.append(reorder_buffer_, it->begin - frame.text_begin, it->end - it->begin);
+    }
+}
+
+void Writer::WriteSeparator(){
+    buffer_ += indented_ ? ",\n"sv : ","sv;
+}
+
+void Writer::WriteIndent(size_t depth){
+    if (indented_){
+        buffer_.append((depth_ + depth) * 4, ' ');
+    }
+}
+
+void Writer::WriteString(string_view str){
+    buffer_ += '"';
+    // Runs of chars which need no escaping are appended as a whole
+    const char* pos = str.data();
+    const char* const end = pos + str.size();
+    while (true) {
+        const char* special = char_scan::FindAnyOf<'"', '\\', '\n', '\r'>(pos, end);
+        buffer_.append(pos, special);
+        if (special == end) {
+            break;
+        }
+        buffer_ += '\\';
+        buffer_ += *special == '\r' ? 'r' : *special == '\n' ? 'n' : *special;
+        pos = special + 1;
+    }
+    buffer_ += '"';
+}
+
+} // namespace json
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "json_builder.h"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json{
+
+// Writes JSON text at once, without building the Node tree. It has the same calls and contexts as Builder,
+// and the text is the same as json::Print of the tree built by Builder gives: dict keys are printed sorted
+// (keys of one dict must differ), arrays and dicts are indented by 4 in the INDENTED layout.
+// The text is collected in memory and passed to the output by Flush.
+class Writer{
+public:
+    // ONE_LINE writes no line breaks and spaces, for JSON Lines
+    enum class Layout{ INDENTED, ONE_LINE };
+
+    // The text of a Writer made with depth is indented as if it were nested in depth containers,
+    // to be inserted with RawValue at that depth
+    explicit Writer(std::ostream& output, Layout layout = Layout::INDENTED, size_t depth = 0);
+
+    KeyContext<Writer> Key(std::string_view key);
+    Writer& Value(std::string_view value);
+    Writer& Value(const char* value);
+    Writer& Value(int value);
+    Writer& Value(double value);
+    Writer& Value(bool value);
+    Writer& Value(std::nullptr_t);
+    // Inserts a value written by another Writer with the same layout and the depth of this place
+    Writer& RawValue(std::string_view text);
+    DictContext<Writer> StartDict();
+    Writer& EndDict();
+    ArrayContext<Writer> StartArray();
+    Writer& EndArray();
+
+    // Passes the text written so far to the output. Not allowed inside a dict, its keys may yet be reordered
+    void Flush();
+
+private:
+    // Opened dict or array
+    struct Frame{
+        bool is_dict = false;
+        size_t first_member = 0;
+        size_t text_begin = 0;
+        bool is_empty = true;
+    };
+    // Text of a dict member (indent, key and value) is buffer_[begin, end)
+    struct Member{
+        std::string key;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::ostream& output_;
+    const bool indented_;
+    const size_t depth_;
+    std::string buffer_;
+    std::vector<Frame> frames_;
+    // Members of all opened dicts, every frame owns the tail from its first_member
+    std::vector<Member> members_;
+    bool expects_value_ = false;
+    // Reused when the members of a dict are reordered
+    std::string reorder_buffer_;
+
+    void BeginValue();
+    void EndValue();
+    void OpenFrame(bool is_dict, char bracket);
+    void CloseFrame(bool is_dict, char bracket);
+    void SortMembers(const Frame& frame);
+    void WriteSeparator();
+    void WriteIndent(size_t depth);
+    void WriteString(std::string_view str);
+};
+
+} // namespace json
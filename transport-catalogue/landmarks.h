@@ -0,0 +1,184 @@
+#pragma once
+
+#include "graph.h"
+#include "graph_search.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// FNV-1a hash of the vertex count and of all edges, the landmark tables are valid only for a graph with the same one
+template <typename Weight>
+uint64_t ComputeGraphFingerprint(const DirectedWeightedGraph<Weight>& graph) {
+    uint64_t hash = 14695981039346656037ULL;
+    const auto add = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    const uint64_t vertex_count = graph.GetVertexCount();
+    add(&vertex_count, sizeof(vertex_count));
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const Edge<Weight>& edge = graph.GetEdge(edge_id);
+        const uint64_t ends[2] = {edge.from, edge.to};
+        add(ends, sizeof(ends));
+        add(&edge.weight, sizeof(edge.weight));
+    }
+    return hash;
+}
+
+// ALT (A*, Landmarks, Triangle inequality) preprocessing.
+// For every landmark L keeps the distances L -> v and v -> L for all vertices v,
+// so that d(s, t) is bounded from below by d(L, t) - d(L, s) and d(s, L) - d(t, L).
+template <typename Weight>
+class Landmarks {
+public:
+    Landmarks() = default;
+
+    // Selects landmarks among candidates with the "farthest" strategy and computes distances
+    Landmarks(const DirectedWeightedGraph<Weight>& graph, const std::vector<VertexId>& candidates, size_t landmark_count);
+
+    // Restores previously computed landmarks
+    Landmarks(size_t vertex_count, uint64_t graph_fingerprint, std::vector<VertexId> vertices,
+              std::vector<Weight> from_landmarks, std::vector<Weight> to_landmarks);
+
+    Weight LowerBound(VertexId from, VertexId to) const;
+
+    // Whether the landmarks were computed for this graph
+    bool IsComputedFor(const DirectedWeightedGraph<Weight>& graph) const;
+
+    size_t GetVertexCount() const;
+    uint64_t GetGraphFingerprint() const;
+    const std::vector<VertexId>& GetVertices() const;
+    const std::vector<Weight>& GetDistancesFromLandmarks() const;
+    const std::vector<Weight>& GetDistancesToLandmarks() const;
+
+private:
+    size_t vertex_count_ = 0;
+    uint64_t graph_fingerprint_ = 0;
+    std::vector<VertexId> vertices_;
+    // landmark-major tables: [landmark_index * vertex_count_ + vertex]
+    std::vector<Weight> from_landmarks_;
+    std::vector<Weight> to_landmarks_;
+
+    void AddLandmark(const DirectedWeightedGraph<Weight>& graph,
+                     const DirectedWeightedGraph<Weight>& reversed_graph, VertexId vertex);
+};
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(const DirectedWeightedGraph<Weight>& graph, const std::vector<VertexId>& candidates,
+                             size_t landmark_count)
+    : vertex_count_(graph.GetVertexCount())
+    , graph_fingerprint_(ComputeGraphFingerprint(graph)) {
+    if (candidates.empty() || landmark_count == 0) {
+        return;
+    }
+    const auto reversed_graph = MakeReversedGraph(graph);
+
+    // The first landmark is the candidate farthest from an arbitrary one,
+    // every next landmark is the candidate farthest from all already selected
+    std::vector<Weight> nearest(vertex_count_, UNREACHABLE<Weight>);
+    const auto start_distances = ComputeDistances(graph, candidates.front());
+    VertexId next = *std::max_element(candidates.begin(), candidates.end(), [&start_distances](VertexId lhs, VertexId rhs){
+        return start_distances[lhs] < start_distances[rhs];
+    });
+
+    while (vertices_.size() < std::min(landmark_count, candidates.size())) {
+        AddLandmark(graph, reversed_graph, next);
+        const Weight* from_last = from_landmarks_.data() + (vertices_.size() - 1) * vertex_count_;
+        for (const VertexId vertex : candidates) {
+            nearest[vertex] = std::min(nearest[vertex], from_last[vertex]);
+        }
+        for (const VertexId landmark : vertices_) {
+            nearest[landmark] = Weight{};
+        }
+        next = *std::max_element(candidates.begin(), candidates.end(), [&nearest](VertexId lhs, VertexId rhs){
+            return nearest[lhs] < nearest[rhs];
+        });
+        if (nearest[next] == Weight{}) {
+            break;
+        }
+    }
+}
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(size_t vertex_count, uint64_t graph_fingerprint, std::vector<VertexId> vertices,
+                             std::vector<Weight> from_landmarks, std::vector<Weight> to_landmarks)
+    : vertex_count_(vertex_count)
+    , graph_fingerprint_(graph_fingerprint)
+    , vertices_(std::move(vertices))
+    , from_landmarks_(std::move(from_landmarks))
+    , to_landmarks_(std::move(to_landmarks)) {
+    if (from_landmarks_.size() != vertices_.size() * vertex_count_
+            || to_landmarks_.size() != vertices_.size() * vertex_count_) {
+        throw std::invalid_argument("Landmark tables do not match the vertex count");
+    }
+}
+
+template <typename Weight>
+Weight Landmarks<Weight>::LowerBound(VertexId from, VertexId to) const {
+    Weight result{};
+    for (size_t i = 0; i < vertices_.size(); ++i) {
+        const Weight* from_landmark = from_landmarks_.data() + i * vertex_count_;
+        const Weight* to_landmark = to_landmarks_.data() + i * vertex_count_;
+        // d(L, to) <= d(L, from) + d(from, to)
+        if (from_landmark[from] != UNREACHABLE<Weight> && from_landmark[to] != UNREACHABLE<Weight>
+                && from_landmark[to] > from_landmark[from] + result) {
+            result = from_landmark[to] - from_landmark[from];
+        }
+        // d(from, L) <= d(from, to) + d(to, L)
+        if (to_landmark[from] != UNREACHABLE<Weight> && to_landmark[to] != UNREACHABLE<Weight>
+                && to_landmark[from] > to_landmark[to] + result) {
+            result = to_landmark[from] - to_landmark[to];
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+bool Landmarks<Weight>::IsComputedFor(const DirectedWeightedGraph<Weight>& graph) const {
+    return vertex_count_ == graph.GetVertexCount() && graph_fingerprint_ == ComputeGraphFingerprint(graph);
+}
+
+template <typename Weight>
+size_t Landmarks<Weight>::GetVertexCount() const {
+    return vertex_count_;
+}
+
+template <typename Weight>
+uint64_t Landmarks<Weight>::GetGraphFingerprint() const {
+    return graph_fingerprint_;
+}
+
+template <typename Weight>
+const std::vector<VertexId>& Landmarks<Weight>::GetVertices() const {
+    return vertices_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& Landmarks<Weight>::GetDistancesFromLandmarks() const {
+    return from_landmarks_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& Landmarks<Weight>::GetDistancesToLandmarks() const {
+    return to_landmarks_;
+}
+
+template <typename Weight>
+void Landmarks<Weight>::AddLandmark(const DirectedWeightedGraph<Weight>& graph,
+                                    const DirectedWeightedGraph<Weight>& reversed_graph, VertexId vertex) {
+    vertices_.push_back(vertex);
+    const auto from_landmark = ComputeDistances(graph, vertex);
+    const auto to_landmark = ComputeDistances(reversed_graph, vertex);
+    from_landmarks_.insert(from_landmarks_.end(), from_landmark.begin(), from_landmark.end());
+    to_landmarks_.insert(to_landmarks_.end(), to_landmark.begin(), to_landmark.end());
+}
+
+}  // namespace graph
@@ -0,0 +1,250 @@
+#include "line_server.h"
+
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace tc{
+namespace service{
+
+namespace {
+
+// Lines may come from Windows clients
+std::string_view TrimLine(std::string_view line){
+    if (!line.empty() && line.back() == '\r'){
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+#ifndef _WIN32
+
+bool SendAll(int fd, std::string_view data){
+#ifdef MSG_NOSIGNAL
+    // A client gone away must not kill the server with SIGPIPE
+    constexpr int flags = MSG_NOSIGNAL;
+#else
+    constexpr int flags = 0;
+#endif
+    while (!data.empty()){
+        const ssize_t sent = send(fd, data.data(), data.size(), flags);
+        if (sent < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+// A client which sends more without a line break is disconnected, instead of being buffered without limit
+constexpr size_t MAX_LINE_SIZE = 16 << 20;
+
+// Write end of the pipe the stop signals are passed through, the accept loop polls the read end
+volatile std::sig_atomic_t stop_pipe_fd = -1;
+
+extern "C" void HandleStopSignal(int){
+    const int saved_errno = errno;
+    const char byte = 0;
+    [[maybe_unused]] const ssize_t written = write(stop_pipe_fd, &byte, 1);
+    errno = saved_errno;
+}
+
+// Passes SIGINT and SIGTERM to the pipe while it exists, the previous handlers are restored after that
+class StopSignals{
+public:
+    StopSignals(){
+        if (pipe(fds_) < 0){
+            fds_[0] = fds_[1] = -1;
+            return;
+        }
+        fcntl(fds_[1], F_SETFL, O_NONBLOCK);
+        stop_pipe_fd = fds_[1];
+        struct sigaction action{};
+        action.sa_handler = HandleStopSignal;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, &old_int_);
+        sigaction(SIGTERM, &action, &old_term_);
+    }
+    StopSignals(const StopSignals&) = delete;
+    StopSignals& operator=(const StopSignals&) = delete;
+    ~StopSignals(){
+        if (fds_[0] < 0){
+            return;
+        }
+        sigaction(SIGINT, &old_int_, nullptr);
+        sigaction(SIGTERM, &old_term_, nullptr);
+        stop_pipe_fd = -1;
+        close(fds_[0]);
+        close(fds_[1]);
+    }
+
+    // -1 if the pipe can not be created, then the server is stopped only by a failing accept
+    int GetFd() const{
+        return fds_[0];
+    }
+
+private:
+    int fds_[2];
+    struct sigaction old_int_{};
+    struct sigaction old_term_{};
+};
+
+void ServeConnection(int fd, const LineHandler& handler){
+    std::string pending;
+    std::string answers;
+    char chunk[1 << 16];
+    bool is_open = true;
+    while (is_open){
+        const ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR){
+            continue;
+        }
+        if (received <= 0){
+            // The last line may have no line break
+            is_open = false;
+            pending += '\n';
+        } else {
+            pending.append(chunk, static_cast<size_t>(received));
+        }
+
+        // All complete lines of the chunk are answered with one send
+        answers.clear();
+        size_t line_begin = 0;
+        for (size_t line_end = pending.find('\n'); line_end != std::string::npos;
+             line_end = pending.find('\n', line_begin)){
+            const std::string_view line = TrimLine(std::string_view(pending).substr(line_begin, line_end - line_begin));
+            if (!line.empty()){
+                answers += handler(line);
+                answers += '\n';
+            }
+            line_begin = line_end + 1;
+        }
+        pending.erase(0, line_begin);
+        if (!answers.empty() && !SendAll(fd, answers)){
+            return;
+        }
+        if (pending.size() > MAX_LINE_SIZE){
+            std::cerr << "Line longer than " << MAX_LINE_SIZE << " bytes, connection closed" << std::endl;
+            return;
+        }
+    }
+}
+
+#endif
+
+} // namespace
+
+void ServeLines(std::istream& input, std::ostream& output, const LineHandler& handler){
+    std::string line;
+    while (std::getline(input, line)){
+        const std::string_view request = TrimLine(line);
+        if (request.empty()){
+            continue;
+        }
+        output << handler(request) << std::endl;
+    }
+}
+
+#ifndef _WIN32
+
+bool ServeUnixSocket(const std::string& path, const LineHandler& handler){
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)){
+        std::cerr << "Bad socket path " << path << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.data(), path.size());
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0){
+        std::cerr << "Can not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+        || listen(listener, SOMAXCONN) < 0){
+        std::cerr << "Can not listen on " << path << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+
+    // Connections are served by detached threads, the handler has to outlive them.
+    // Open connections are kept to be shut down on stop
+    std::mutex mutex;
+    std::condition_variable all_closed;
+    std::set<int> connections;
+
+    const StopSignals stop_signals;
+    while (true){
+        pollfd fds[2] = {{listener, POLLIN, 0}, {stop_signals.GetFd(), POLLIN, 0}};
+        if (poll(fds, stop_signals.GetFd() < 0 ? 1 : 2, -1) < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            std::cerr << "Can not wait for connections: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[1].revents != 0){
+            break;
+        }
+        const int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0){
+            if (errno == EINTR || errno == ECONNABORTED){
+                continue;
+            }
+            std::cerr << "Can not accept connection: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        {
+            std::lock_guard guard(mutex);
+            connections.insert(fd);
+        }
+        std::thread([fd, &handler, &mutex, &all_closed, &connections](){
+            ServeConnection(fd, handler);
+            std::lock_guard guard(mutex);
+            // Closed under the mutex, so the stop does not shut down another socket given the same number
+            close(fd);
+            connections.erase(fd);
+            all_closed.notify_all();
+        }).detach();
+    }
+
+    close(listener);
+    unlink(path.c_str());
+    std::unique_lock lock(mutex);
+    // Further reads of the connections end as if the clients closed them, the lines already received are answered
+    for (const int fd : connections){
+        shutdown(fd, SHUT_RD);
+    }
+    all_closed.wait(lock, [&connections](){ return connections.empty(); });
+    return true;
+}
+
+#else
+
+bool ServeUnixSocket(const std::string& path, const LineHandler&){
+    std::cerr << "Unix domain sockets are not supported, can not listen on " << path << std::endl;
+    return false;
+}
+
+#endif
+
+} // namespace service
+} // namespace tc
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace tc{
+namespace service{
+
+// Makes the answer line for a request line, without the line break
+using LineHandler = std::function<std::string(std::string_view line)>;
+
+// Answers every line of the input with one line of the output, flushed at once, until the input ends.
+// Empty lines are skipped.
+void ServeLines(std::istream& input, std::ostream& output, const LineHandler& handler);
+
+// Listens on a Unix domain socket and serves every connection like ServeLines in its own thread,
+// so the handler has to be thread safe. A connection sending a line longer than 16 MiB is closed.
+// A stale socket file left at the path is replaced.
+// Serves until SIGINT or SIGTERM (or until accept fails): then stops accepting, lets every connection finish
+// the lines it has received, removes the socket file and returns true.
+// Returns false if the socket can not be opened. Not supported on Windows, where it returns false at once.
+bool ServeUnixSocket(const std::string& path, const LineHandler& handler);
+
+} // namespace service
+} // namespace tc
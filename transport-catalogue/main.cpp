@@ -1,28 +1,70 @@
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
 #include <fstream>
 #include <iostream>
 #include <string_view>
+#include <thread>
 
 #include "request_handler.h"
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests [--threads <count>]]\n"sv
+           << "       transport_catalogue serve <base file> [--socket <path>]\n"sv;
+}
+
+// 0 if the count is not a number
+size_t ReadThreadCount(std::string_view count) {
+    size_t result = 0;
+    const auto [end, ec] = std::from_chars(count.data(), count.data() + count.size(), result);
+    if (ec != std::errc{} || end != count.data() + count.size()) {
+        return 0;
+    }
+    return result;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
+    if (mode == "serve"sv) {
+        if (argc == 3) {
+            return Serve(argv[2], {}) ? 0 : 1;
+        }
+        if (argc == 5 && argv[3] == "--socket"sv) {
+            return Serve(argv[2], argv[4]) ? 0 : 1;
+        }
+        PrintUsage();
+        return 1;
+    }
+
+    if (mode == "process_requests"sv && argc == 4 && argv[2] == "--threads"sv) {
+        const size_t thread_count = ReadThreadCount(argv[3]);
+        if (thread_count == 0) {
+            PrintUsage();
+            return 1;
+        }
+        ProcessRequests(thread_count);
+        return 0;
+    }
+
+    if (argc != 2) {
+        PrintUsage();
+        return 1;
+    }
+
     if (mode == "make_base"sv) {
         MakeBase();
 //        std::cerr << "MakeBase() OK"s <<std::endl;
     } else if (mode == "process_requests"sv) {
-        ProcessRequests();
+        // All cores by default
+        ProcessRequests(std::max(std::thread::hardware_concurrency(), 1u));
     } else {
         PrintUsage();
         return 1;
@@ -24,39 +24,40 @@ MapRenderer::MapRenderer(RenderSettings render_settings)
 
 svg::Document MapRenderer::RenderMap(const tc::TransportCatalogue& tc) const{
     svg::Document result;
-    auto bus_names = tc.GetAllBusNames();
+    result.SetPrecision(render_settings_.coordinate_precision);
+    auto bus_ids = tc.GetAllBusIds();
 
-    auto proj = CreateSphereProjectionForBuses(tc, bus_names);
+    auto proj = CreateSphereProjectionForBuses(tc, bus_ids);
     // Lines
-    AddRouteLinesToSVG(result, tc, bus_names, proj);
+    AddRouteLinesToSVG(result, tc, bus_ids, proj);
     // Text
-    AddBusNamesToSVG(result, tc, bus_names, proj);
+    AddBusNamesToSVG(result, tc, bus_ids, proj);
     // Circle
-    auto stop_names = tc.GetAllStopNames();
-    AddStopCircleToSVG(result, tc, stop_names, proj);
+    auto stop_ids = tc.GetAllStopIds();
+    AddStopCircleToSVG(result, tc, stop_ids, proj);
     //Stop names
-    AddStopNamesToSVG(result, tc, stop_names, proj);
+    AddStopNamesToSVG(result, tc, stop_ids, proj);
 
     return result;
 }
 
-SphereProjector MapRenderer::CreateSphereProjectionForBuses(const tc::TransportCatalogue& tc, const std::set<std::string_view>& bus_names) const{
+SphereProjector MapRenderer::CreateSphereProjectionForBuses(const tc::TransportCatalogue& tc, tc::BusIdRange bus_ids) const{
     vector<tc::geo::Coordinates> all_coordinates;
-    for (const auto bus_name : bus_names){
-        for (const auto stop : tc.GetBusRoute(bus_name)){
-            all_coordinates.push_back(stop->coordinates);
+    for (const auto bus_id : bus_ids){
+        for (const auto stop_id : tc.GetBusRoute(bus_id).GetStoredStops()){
+            all_coordinates.push_back(tc.GetStopCoordinates(stop_id));
         }
     }
     return SphereProjector(all_coordinates.begin(), all_coordinates.end(),
             render_settings_.width, render_settings_.height, render_settings_.padding);
 }
 
-void MapRenderer::AddRouteLinesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& bus_names, const SphereProjector& proj) const{
+void MapRenderer::AddRouteLinesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::BusIdRange bus_ids, const SphereProjector& proj) const{
     int i = 0;
-    for (auto it = bus_names.begin(); it != bus_names.end(); ++it, ++i){
+    for (auto it = bus_ids.begin(); it != bus_ids.end(); ++it, ++i){
         svg::Polyline polyline;
-        for (const auto stop : tc.GetBusRoute(*it)){
-            polyline.AddPoint(proj(stop->coordinates));
+        for (const auto stop_id : tc.GetBusRoute(*it)){
+            polyline.AddPoint(proj(tc.GetStopCoordinates(stop_id)));
         }
         polyline.SetFillColor("none"s)
                 .SetStrokeColor(render_settings_.color_palette[i % render_settings_.color_palette.size()])
@@ -67,20 +68,20 @@ void MapRenderer::AddRouteLinesToSVG(svg::Document& to_svg, const tc::TransportC
     }
 }
 
-void MapRenderer::AddBusNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& bus_names, const SphereProjector& proj) const{
+void MapRenderer::AddBusNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::BusIdRange bus_ids, const SphereProjector& proj) const{
     int i = 0;
-    for (auto it = bus_names.begin(); it != bus_names.end(); ++it, ++i){
-        auto root = tc.GetBusRoute(*it);
+    for (auto it = bus_ids.begin(); it != bus_ids.end(); ++it, ++i){
+        const auto root = tc.GetBusRoute(*it);
         if (root.empty()){
             continue;
         }
         svg::Text under_text;
-        under_text.SetPosition(proj(root[0]->coordinates))
+        under_text.SetPosition(proj(tc.GetStopCoordinates(root[0])))
                   .SetOffset({render_settings_.bus_label_offset.dx, render_settings_.bus_label_offset.dy})
                   .SetFontSize(render_settings_.bus_label_font_size)
                   .SetFontFamily("Verdana"s)
                   .SetFontWeight("bold"s)
-                  .SetData(string(*it));
+                  .SetData(string(tc.GetBusName(*it)));
         svg::Text text = under_text;
 
         under_text.SetFillColor(render_settings_.underlayer_color).SetStrokeColor(render_settings_.underlayer_color)
@@ -91,23 +92,22 @@ void MapRenderer::AddBusNamesToSVG(svg::Document& to_svg, const tc::TransportCat
         text.SetFillColor(render_settings_.color_palette[i % render_settings_.color_palette.size()]);
         to_svg.Add(under_text);
         to_svg.Add(text);
-        if (!tc.BusIsRoundtrip(*it) && root[root.size()/2] != root[0]){
-            under_text.SetPosition(proj(root[root.size()/2]->coordinates));
-            text.SetPosition(proj(root[root.size()/2]->coordinates));
+        if (!root.IsRoundtrip() && root[root.size()/2] != root[0]){
+            under_text.SetPosition(proj(tc.GetStopCoordinates(root[root.size()/2])));
+            text.SetPosition(proj(tc.GetStopCoordinates(root[root.size()/2])));
             to_svg.Add(under_text);
             to_svg.Add(text);
         }
     }
 }
 
-void MapRenderer::AddStopCircleToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& stop_names, const SphereProjector& proj) const{
-    for (const auto stop_name : stop_names){
-        if (!tc.StopHaveBus(stop_name)){
+void MapRenderer::AddStopCircleToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::StopIdRange stop_ids, const SphereProjector& proj) const{
+    for (const auto stop_id : stop_ids){
+        if (!tc.StopHaveBus(stop_id)){
             continue;
         }
         svg::Circle stop_circle;
-        auto stop = tc.GetStopInfo(stop_name);
-        stop_circle.SetCenter(proj(stop->coordinates))
+        stop_circle.SetCenter(proj(tc.GetStopCoordinates(stop_id)))
                    .SetRadius(render_settings_.stop_radius)
                    .SetFillColor("white"s);
 
@@ -115,19 +115,18 @@ void MapRenderer::AddStopCircleToSVG(svg::Document& to_svg, const tc::TransportC
     }
 }
 
-void MapRenderer::AddStopNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& stop_names, const SphereProjector& proj) const{
-    for (const auto stop_name : stop_names){
-        if (!tc.StopHaveBus(stop_name)){
+void MapRenderer::AddStopNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::StopIdRange stop_ids, const SphereProjector& proj) const{
+    for (const auto stop_id : stop_ids){
+        if (!tc.StopHaveBus(stop_id)){
             continue;
         }
 
-        auto stop = tc.GetStopInfo(stop_name);
         svg::Text under_text;
-        under_text.SetPosition(proj(stop->coordinates))
+        under_text.SetPosition(proj(tc.GetStopCoordinates(stop_id)))
                   .SetOffset({render_settings_.stop_label_offset.dx, render_settings_.stop_label_offset.dy})
                   .SetFontSize(render_settings_.stop_label_font_size)
                   .SetFontFamily("Verdana"s)
-                  .SetData(string(stop_name));
+                  .SetData(string(tc.GetStopName(stop_id)));
 
         svg::Text text = under_text;
         under_text.SetFillColor(render_settings_.underlayer_color).SetStrokeColor(render_settings_.underlayer_color)
@@ -41,6 +41,9 @@ struct RenderSettings{
     svg::Color underlayer_color;
     double underlayer_width = 0.0;
     std::vector<svg::Color> color_palette;
+
+    // Digits after the point in map coordinates, -1 gives the shortest exact text
+    int coordinate_precision = -1;
 };
 
 class SphereProjector {
@@ -70,12 +73,12 @@ public:
 private:
     RenderSettings render_settings_;
 
-    SphereProjector CreateSphereProjectionForBuses(const tc::TransportCatalogue& tc, const std::set<std::string_view>& bus_names) const;
+    SphereProjector CreateSphereProjectionForBuses(const tc::TransportCatalogue& tc, tc::BusIdRange bus_ids) const;
 
-    void AddRouteLinesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& bus_names, const SphereProjector& proj) const;
-    void AddBusNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& bus_names, const SphereProjector& proj) const;
-    void AddStopCircleToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& stop_names, const SphereProjector& proj) const;
-    void AddStopNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, const std::set<std::string_view>& stop_names, const SphereProjector& proj) const;
+    void AddRouteLinesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::BusIdRange bus_ids, const SphereProjector& proj) const;
+    void AddBusNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::BusIdRange bus_ids, const SphereProjector& proj) const;
+    void AddStopCircleToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::StopIdRange stop_ids, const SphereProjector& proj) const;
+    void AddStopNamesToSVG(svg::Document& to_svg, const tc::TransportCatalogue& tc, tc::StopIdRange stop_ids, const SphereProjector& proj) const;
 };
 
 template <typename PointInputIt>
@@ -0,0 +1,43 @@
+#include "number_format.h"
+
+#include <charconv>
+#include <system_error>
+
+namespace number_format {
+
+char* WriteDouble(char* first, char* last, double value){
+    return std::to_chars(first, last, value).ptr;
+}
+
+char* WriteDouble(char* first, char* last, double value, int precision){
+    if (precision < 0){
+        return WriteDouble(first, last, value);
+    }
+    const auto [end, ec] = std::to_chars(first, last, value, std::chars_format::fixed, precision);
+    // Too long in the fixed form, such values are not coordinates
+    if (ec != std::errc{}){
+        return WriteDouble(first, last, value);
+    }
+    char* result = end;
+    if (precision > 0){
+        while (result[-1] == '0'){
+            --result;
+        }
+        if (result[-1] == '.'){
+            --result;
+        }
+    }
+    // Small negative values are rounded to "-0"
+    if (result - first == 2 && first[0] == '-' && first[1] == '0'){
+        first[0] = '0';
+        --result;
+    }
+    return result;
+}
+
+void PrintDouble(std::ostream& out, double value, int precision){
+    char str[MAX_DOUBLE_SIZE];
+    out.write(str, WriteDouble(str, str + MAX_DOUBLE_SIZE, value, precision) - str);
+}
+
+} // namespace number_format
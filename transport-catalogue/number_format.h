@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+// Locale independent writing of doubles, shared by the JSON and SVG output
+namespace number_format {
+
+// Enough for any double written by WriteDouble
+inline constexpr size_t MAX_DOUBLE_SIZE = 64;
+
+// Writes the shortest text which reads back as the same value (std::to_chars), returns the end of the text
+char* WriteDouble(char* first, char* last, double value);
+// Writes the value rounded to precision digits after the point without trailing zeros,
+// a negative precision gives the shortest text as above
+char* WriteDouble(char* first, char* last, double value, int precision);
+
+void PrintDouble(std::ostream& out, double value, int precision = -1);
+
+} // namespace number_format
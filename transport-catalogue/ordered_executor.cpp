@@ -0,0 +1,144 @@
+#include "ordered_executor.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace parallel {
+
+OrderedExecutor::OrderedExecutor(size_t thread_count, Consumer consumer, size_t max_pending)
+    : consumer_(std::move(consumer))
+    , max_pending_(max_pending != 0 ? max_pending : std::max<size_t>(thread_count, 1) * 256)
+    , queue_count_(std::max<size_t>(thread_count, 1))
+    , slots_(max_pending_) {
+    queues_ = std::make_unique<WorkerQueue[]>(queue_count_);
+    workers_.reserve(queue_count_);
+    for (size_t worker = 0; worker < queue_count_; ++worker) {
+        workers_.emplace_back([this, worker]() {
+            Work(worker);
+        });
+    }
+}
+
+OrderedExecutor::~OrderedExecutor() {
+    {
+        std::lock_guard guard(idle_mutex_);
+        is_stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void OrderedExecutor::Submit(Task task) {
+    size_t index = 0;
+    {
+        std::unique_lock lock(result_mutex_);
+        result_consumed_.wait(lock, [this]() {
+            return error_ || submitted_ - next_result_ < max_pending_;
+        });
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        index = submitted_++;
+    }
+    WorkerQueue& queue = queues_[index % queue_count_];
+    {
+        std::lock_guard guard(queue.mutex);
+        queue.jobs.push_back({index, std::move(task)});
+        // Counted before the queue is unlocked, so no worker takes the job before it is counted
+        std::lock_guard idle_guard(idle_mutex_);
+        ++queued_;
+    }
+    work_ready_.notify_one();
+}
+
+void OrderedExecutor::Finish() {
+    std::unique_lock lock(result_mutex_);
+    result_consumed_.wait(lock, [this]() {
+        return error_ || next_result_ == submitted_;
+    });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void OrderedExecutor::Work(size_t worker) {
+    Job job;
+    while (true) {
+        if (TakeJob(worker, job)) {
+            Slot slot;
+            slot.is_ready = true;
+            try {
+                slot.result = job.task();
+            } catch (...) {
+                slot.error = std::current_exception();
+                size_t failed = first_failed_;
+                while (job.index < failed && !first_failed_.compare_exchange_weak(failed, job.index)) {
+                }
+            }
+            // The captures of the task are released before it waits for the sequencer
+            job.task = nullptr;
+            Complete(job.index, std::move(slot));
+            continue;
+        }
+        std::unique_lock lock(idle_mutex_);
+        work_ready_.wait(lock, [this]() {
+            return queued_ > 0 || is_stopping_;
+        });
+        if (queued_ == 0) {
+            return;
+        }
+    }
+}
+
+bool OrderedExecutor::TakeJob(size_t worker, Job& job) {
+    // The own queue first, then the others
+    for (size_t i = 0; i < queue_count_; ++i) {
+        WorkerQueue& queue = queues_[(worker + i) % queue_count_];
+        std::lock_guard guard(queue.mutex);
+        while (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            --queued_;
+            if (job.index < first_failed_) {
+                return true;
+            }
+            // Its result would never be consumed
+            job.task = nullptr;
+        }
+    }
+    return false;
+}
+
+void OrderedExecutor::Complete(size_t index, Slot slot) {
+    std::unique_lock lock(result_mutex_);
+    slots_[index % max_pending_] = std::move(slot);
+    // The running sequencer takes this result when it gets to it
+    if (is_sequencing_) {
+        return;
+    }
+    is_sequencing_ = true;
+    while (!error_ && next_result_ < submitted_) {
+        Slot& next = slots_[next_result_ % max_pending_];
+        if (!next.is_ready) {
+            break;
+        }
+        if (next.error) {
+            error_ = next.error;
+            break;
+        }
+        const std::string result = std::move(next.result);
+        next = Slot{};
+        // Other workers store their results meanwhile
+        lock.unlock();
+        consumer_(result);
+        lock.lock();
+        ++next_result_;
+        result_consumed_.notify_all();
+    }
+    is_sequencing_ = false;
+    result_consumed_.notify_all();
+}
+
+} // namespace parallel
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Runs tasks on a fixed set of threads and passes their results to the consumer in the order
+// the tasks were submitted, so the output is the same as running them one by one.
+//
+// Every worker owns a queue of tasks: submitted tasks are dealt to the queues in turn, a worker takes
+// tasks from its own queue and, when it is empty, steals from the others. Tasks are always taken oldest
+// first, a result the consumer waits for is not left behind newer ones.
+// A finished result waits in its slot until all earlier ones are consumed; the thread which fills
+// the first missing slot becomes the sequencer and passes on the run of ready results.
+// At most max_pending results are held (0 gives 256 per thread), Submit waits for the consumer when there are more.
+//
+// The consumer is called by one thread at a time, by workers, never by Submit.
+// If a task throws, no later result is consumed and Submit or Finish rethrows the exception.
+// Later tasks not started yet are dropped, the earlier ones still run so that their results are consumed.
+class OrderedExecutor {
+public:
+    using Task = std::function<std::string()>;
+    using Consumer = std::function<void(std::string_view result)>;
+
+    OrderedExecutor(size_t thread_count, Consumer consumer, size_t max_pending = 0);
+    OrderedExecutor(const OrderedExecutor&) = delete;
+    OrderedExecutor& operator=(const OrderedExecutor&) = delete;
+    // Waits for the tasks already submitted
+    ~OrderedExecutor();
+
+    void Submit(Task task);
+    // Waits until the results of all submitted tasks are consumed
+    void Finish();
+
+private:
+    struct Job {
+        size_t index = 0;
+        Task task;
+    };
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+    struct Slot {
+        bool is_ready = false;
+        std::string result;
+        std::exception_ptr error;
+    };
+
+    const Consumer consumer_;
+    const size_t max_pending_;
+
+    std::unique_ptr<WorkerQueue[]> queues_;
+    size_t queue_count_ = 0;
+    // Number of jobs in all queues. Increased under idle_mutex_, so an idle worker does not miss it,
+    // and under the mutex of the queue, so it is never decreased before being increased
+    std::atomic<size_t> queued_ = 0;
+    // Index of the first task known to have thrown, the tasks after it are not run
+    std::atomic<size_t> first_failed_ = std::numeric_limits<size_t>::max();
+    bool is_stopping_ = false;
+    std::mutex idle_mutex_;
+    std::condition_variable work_ready_;
+
+    // Results of tasks [next_result_, submitted_), slot of task i is slots_[i % max_pending_]
+    std::vector<Slot> slots_;
+    size_t submitted_ = 0;
+    size_t next_result_ = 0;
+    bool is_sequencing_ = false;
+    std::exception_ptr error_;
+    std::mutex result_mutex_;
+    std::condition_variable result_consumed_;
+
+    std::vector<std::thread> workers_;
+
+    void Work(size_t worker);
+    bool TakeJob(size_t worker, Job& job);
+    void Complete(size_t index, Slot slot);
+};
+
+} // namespace parallel
@@ -8,30 +8,55 @@
 #include "json.h"
 #include "json_reader.h"
 #include "serialization.h"
+#include "transport_router.h"
+#include "catalogue_service.h"
+#include "line_server.h"
 
 void MakeBase(){
-    json::Node main_node = tc::reader::LoadJSON(std::cin);
-
     tc::TransportCatalogue tc;
+    // The tree is built only for the settings, stops and buses go to the catalogue while they are read
+    json::Node main_node = tc::reader::LoadBaseFromJSON(tc, std::cin);
+
     tc::renderer::RenderSettings render_set;
     tc::router::RoutingSettings routing_set;
 
     tc::reader::MakeBaseFromJSON(tc, render_set, routing_set, main_node);
 
-    std::string filename = tc::reader::ReadSerializationSettingsFromJSON(main_node);
-    tc::serialization::Serialize(tc, render_set, routing_set, filename);
-}
-
-void ProcessRequests(){
-    json::Node main_node = tc::reader::LoadJSON(std::cin);
+    // Landmarks for goal-directed routing are precomputed once and stored in the base
+    tc::router::Router router(routing_set, tc);
 
     std::string filename = tc::reader::ReadSerializationSettingsFromJSON(main_node);
+    tc::serialization::Serialize(tc, render_set, routing_set, router.GetLandmarks(), filename);
+}
 
-    tc::TransportCatalogue tc;
-    tc::renderer::RenderSettings render_set;
-    tc::router::RoutingSettings routing_set;
-
-    tc::serialization::Deserialize(tc, render_set, routing_set, filename);
+void ProcessRequests(size_t thread_count){
+    // Requests are answered while they are read, the base is loaded when its file name is known
+    tc::reader::AnswerStatRequestsFromJSON(std::cin, std::cout, [](const std::string& filename){
+        tc::TransportCatalogue tc;
+        tc::renderer::RenderSettings render_set;
+        tc::router::RoutingSettings routing_set;
+        tc::router::Landmarks landmarks;
+
+        // A base that can not be read gives an empty catalogue, every request is answered "not found"
+        tc::serialization::Deserialize(tc, render_set, routing_set, landmarks, filename);
+        return tc::service::MakeState(std::move(tc), render_set, routing_set, std::move(landmarks));
+    }, thread_count);
+}
 
-    tc::reader::ProcessRequestFromJSON(tc, render_set, routing_set, main_node);
+bool Serve(const std::string& filename, const std::string& socket_path){
+    tc::service::StatePtr state = tc::service::LoadState(filename);
+    if (!state){
+        std::cerr << "Can not read base " << filename << std::endl;
+        return false;
+    }
+    // Requests of all connections share the handle, a Reload request replaces the base for all of them
+    tc::service::StateHandle handle(std::move(state));
+    const tc::service::LineHandler answer = [&handle, &filename](std::string_view line){
+        return tc::reader::AnswerStatRequestLine(handle, filename, line);
+    };
+    if (socket_path.empty()){
+        tc::service::ServeLines(std::cin, std::cout, answer);
+        return true;
+    }
+    return tc::service::ServeUnixSocket(socket_path, answer);
 }
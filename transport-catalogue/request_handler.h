@@ -1,4 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 void MakeBase();
-void ProcessRequests();
+// Stat requests are answered on thread_count threads, the output does not depend on it
+void ProcessRequests(size_t thread_count);
+
+// Loads the base once and answers stat requests given as JSON Lines, from stdin or,
+// with a non-empty socket_path, from the connections to that Unix domain socket, until SIGINT or SIGTERM.
+// Reload requests can only load the same file again. Returns false if the base or the socket can not be opened
+bool Serve(const std::string& filename, const std::string& socket_path);
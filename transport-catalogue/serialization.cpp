@@ -1,5 +1,6 @@
 #include "serialization.h"
 
+#include <algorithm>
 #include <fstream>
 #include <set>
 #include <string>
@@ -21,12 +22,14 @@ namespace tc {
 namespace serialization {
 
 void Serialize(const tc::TransportCatalogue& tc, const tc::renderer::RenderSettings& render_set,
-               const tc::router::RoutingSettings& routing_set, const std::string& filename){
+               const tc::router::RoutingSettings& routing_set, const tc::router::Landmarks& landmarks,
+               const std::string& filename){
 
     tc_serialization::FullModulePack full_pack;
     *full_pack.mutable_transport_catalogue() = std::move(SerializeTransportCatalogue(tc));
     *full_pack.mutable_render_set() = std::move(SerializeRenderSettings(render_set));
     *full_pack.mutable_routing_set() = std::move(SerializeRoutingSettings(routing_set));
+    *full_pack.mutable_landmarks() = std::move(SerializeLandmarks(landmarks));
 
     ofstream ofs(filename, ios::binary);
     full_pack.SerializeToOstream(&ofs);
@@ -36,30 +39,21 @@ tc_serialization::TransportCatalogue SerializeTransportCatalogue(const tc::Trans
     tc_serialization::TransportCatalogue tc_pb;
     SerializeStop(tc_pb, tc);
     SerializeBus(tc_pb, tc);
+    *tc_pb.mutable_stop_grid() = SerializeStopGrid(tc);
     return std::move(tc_pb);
 }
 
 void SerializeStop(tc_serialization::TransportCatalogue& tc_pb, const tc::TransportCatalogue& tc){
-    // road_distances
-    unordered_map<string_view, vector<pair<string, int>>> stopname_to_road_stop_;
-    auto distances_table = tc.GetDistancesTable();
-    for (const auto [key, dist] : distances_table){
-        stopname_to_road_stop_[key.first->name].push_back(make_pair(string(key.second->name), dist));
-    }
-
     // stop
-    const auto stop_names = tc.GetAllStopNames();
-    for (const auto stop : stop_names){
-        const Stop* stop_info = tc.GetStopInfo(stop);
+    for (const auto stop_id : tc.GetAllStopIds()){
+        const auto coordinates = tc.GetStopCoordinates(stop_id);
         tc_serialization::Stop sstop;
-        sstop.set_name(string(stop_info->name));
-        sstop.set_lat(stop_info->coordinates.lat);
-        sstop.set_lng(stop_info->coordinates.lng);
-        if (stopname_to_road_stop_.count(sstop.name()) != 0 && stopname_to_road_stop_.at(sstop.name()).size() != 0){
-            for (const auto& [to_stop_name, dist] : stopname_to_road_stop_.at(sstop.name())){
-                sstop.add_to_stop(string(to_stop_name));
-                sstop.add_dist(dist);
-            }
+        sstop.set_name(string(tc.GetStopName(stop_id)));
+        sstop.set_lat(coordinates.lat);
+        sstop.set_lng(coordinates.lng);
+        for (const auto& [to_stop_id, dist] : tc.GetRoadDistances(stop_id)){
+            sstop.add_to_stop(string(tc.GetStopName(to_stop_id)));
+            sstop.add_dist(dist);
         }
 
         *tc_pb.add_stop() = sstop;
@@ -67,20 +61,59 @@ void SerializeStop(tc_serialization::TransportCatalogue& tc_pb, const tc::Transp
 }
 
 void SerializeBus(tc_serialization::TransportCatalogue& tc_pb, const tc::TransportCatalogue& tc){
-    const auto bus_names = tc.GetAllBusNames();
-    for (const auto bus_name : bus_names){
+    for (const auto bus_id : tc.GetAllBusIds()){
+        const auto route = tc.GetBusRoute(bus_id);
         tc_serialization::Bus sbus;
-        sbus.set_name(std::string(bus_name));
-        sbus.set_is_roundtrip(tc.BusIsRoundtrip(bus_name));
-        const auto stops = tc.GetBusRoute(bus_name);
-        size_t size = tc.BusIsRoundtrip(bus_name) ? stops.size() : stops.size()/2 + 1;
-        for (size_t i = 0 ; i < size; ++i){
-            sbus.add_route_stop(string(stops[i]->name));
+        sbus.set_name(string(tc.GetBusName(bus_id)));
+        sbus.set_is_roundtrip(route.IsRoundtrip());
+        for (const auto stop_id : route.GetStoredStops()){
+            sbus.add_route_stop(string(tc.GetStopName(stop_id)));
         }
+        *sbus.mutable_statistics() = SerializeRouteStatistics(tc.GetStatistics(sbus.name()));
         *tc_pb.add_bus() = sbus;
     }
 }
 
+tc_serialization::StopGrid SerializeStopGrid(const tc::TransportCatalogue& tc){
+    // Stops are written in name order and get ids in that order when the base is read,
+    // so the grid refers to them by position
+    vector<uint32_t> stop_positions(tc.GetStopCount());
+    uint32_t position = 0;
+    for (const auto stop_id : tc.GetAllStopIds()){
+        stop_positions[stop_id] = position++;
+    }
+
+    const auto& grid = tc.GetStopGrid();
+    const auto& layout = grid.GetLayout();
+    tc_serialization::StopGrid grid_pb;
+    grid_pb.set_min_lat(layout.min_lat);
+    grid_pb.set_min_lng(layout.min_lng);
+    grid_pb.set_cell_lat(layout.cell_lat);
+    grid_pb.set_cell_lng(layout.cell_lng);
+    grid_pb.set_rows(layout.rows);
+    grid_pb.set_cols(layout.cols);
+    const auto& offsets = grid.GetCellOffsets();
+    *grid_pb.mutable_cell_offset() = {offsets.begin(), offsets.end()};
+    for (const auto stop_id : grid.GetCellStops()){
+        grid_pb.add_cell_stop(stop_positions[stop_id]);
+    }
+    // Stops of every cell stay ordered by id
+    for (size_t i = 0; i + 1 < offsets.size(); ++i){
+        sort(grid_pb.mutable_cell_stop()->begin() + offsets[i], grid_pb.mutable_cell_stop()->begin() + offsets[i + 1]);
+    }
+    return grid_pb;
+}
+
+tc_serialization::RouteStatistics SerializeRouteStatistics(const tc::RouteStatistics& stat){
+    tc_serialization::RouteStatistics stat_pb;
+    stat_pb.set_stops(stat.stops);
+    stat_pb.set_unique_stops(stat.unique_stops);
+    stat_pb.set_route_length(stat.route_length);
+    stat_pb.set_route_length_geo(stat.route_length_geo);
+    stat_pb.set_curvature(stat.curvature);
+    return stat_pb;
+}
+
 tc_serialization::Color SerializeSVGColor(const svg::Color& from_color){
     tc_serialization::Color color;
     if (holds_alternative<string>(from_color)){
@@ -134,6 +167,9 @@ tc_serialization::RenderSettings SerializeRenderSettings(const tc::renderer::Ren
     for(const auto& color : render_set.color_palette){
         *render_set_pb.add_color_palette() = SerializeSVGColor(color);
     }
+    if (render_set.coordinate_precision >= 0){
+        render_set_pb.set_coordinate_precision(render_set.coordinate_precision);
+    }
 
     return std::move(render_set_pb);
 }
@@ -143,29 +179,66 @@ tc_serialization::RoutingSettings SerializeRoutingSettings(const tc::router::Rou
 
     routing_set_pb.set_bus_wait_time(routing_set.bus_wait_time);
     routing_set_pb.set_bus_velocity(routing_set.bus_velocity);
+    routing_set_pb.set_landmark_count(routing_set.landmark_count);
+    routing_set_pb.set_pareto_label_limit(routing_set.pareto_label_limit);
 
    return std::move(routing_set_pb);
 }
 
+tc_serialization::Landmarks SerializeLandmarks(const tc::router::Landmarks& landmarks){
+    tc_serialization::Landmarks landmarks_pb;
+
+    landmarks_pb.set_vertex_count(landmarks.GetVertexCount());
+    landmarks_pb.set_graph_fingerprint(landmarks.GetGraphFingerprint());
+    for (const auto vertex : landmarks.GetVertices()){
+        landmarks_pb.add_vertex(vertex);
+    }
+    *landmarks_pb.mutable_from_landmark() = {landmarks.GetDistancesFromLandmarks().begin(),
+                                             landmarks.GetDistancesFromLandmarks().end()};
+    *landmarks_pb.mutable_to_landmark() = {landmarks.GetDistancesToLandmarks().begin(),
+                                           landmarks.GetDistancesToLandmarks().end()};
+
+    return landmarks_pb;
+}
+
 
 //----------- Deserialization ------------
 
-void Deserialize(tc::TransportCatalogue& tc, tc::renderer::RenderSettings& render_set,
-                 tc::router::RoutingSettings& routing_set, const std::string& filename){
+bool Deserialize(tc::TransportCatalogue& tc, tc::renderer::RenderSettings& render_set,
+                 tc::router::RoutingSettings& routing_set, tc::router::Landmarks& landmarks,
+                 const std::string& filename){
     tc_serialization::FullModulePack full_pack;
 
     std::ifstream ifs(filename, std::ios_base::binary);
-    if (!full_pack.ParseFromIstream(&ifs)) {
-        return;
+    if (!ifs || !full_pack.ParseFromIstream(&ifs)) {
+        return false;
     }
 
     tc = tc::serialization::DeserializeTransportCatalogue(full_pack.transport_catalogue());
     render_set = tc::serialization::DeserializeRenderSettings(full_pack.render_set());
     routing_set = tc::serialization::DeserializeRoutingSettings(full_pack.routing_set());
+    landmarks = tc::serialization::DeserializeLandmarks(full_pack.landmarks());
+    return true;
 }
 
 tc::router::RoutingSettings DeserializeRoutingSettings(const tc_serialization::RoutingSettings& routing_set_pb){
-    return {routing_set_pb.bus_wait_time(), routing_set_pb.bus_velocity()};
+    tc::router::RoutingSettings routing_set{routing_set_pb.bus_wait_time(), routing_set_pb.bus_velocity()};
+    if (routing_set_pb.has_landmark_count()){
+        routing_set.landmark_count = routing_set_pb.landmark_count();
+    }
+    if (routing_set_pb.has_pareto_label_limit()){
+        routing_set.pareto_label_limit = routing_set_pb.pareto_label_limit();
+    }
+    return routing_set;
+}
+
+tc::router::Landmarks DeserializeLandmarks(const tc_serialization::Landmarks& landmarks_pb){
+    // Bases written before the fingerprint was stored have 0, their landmarks are computed again
+    return {landmarks_pb.vertex_count(),
+            landmarks_pb.graph_fingerprint(),
+            {landmarks_pb.vertex().begin(), landmarks_pb.vertex().end()},
+            {landmarks_pb.from_landmark().begin(), landmarks_pb.from_landmark().end()},
+            {landmarks_pb.to_landmark().begin(), landmarks_pb.to_landmark().end()}};
 }
 
 tc::renderer::RenderSettings DeserializeRenderSettings(const tc_serialization::RenderSettings& render_set_pb){
@@ -192,6 +265,9 @@ tc::renderer::RenderSettings DeserializeRenderSettings(const tc_serialization::R
     for (size_t i = 0; i < render_set_pb.color_palette_size(); ++i){
         render_set.color_palette.push_back(DeserializeSVGColor(render_set_pb.color_palette(i)));
     }
+    if (render_set_pb.has_coordinate_precision()){
+        render_set.coordinate_precision = render_set_pb.coordinate_precision();
+    }
 
     return render_set;
 }
@@ -211,6 +287,11 @@ tc::TransportCatalogue DeserializeTransportCatalogue(const tc_serialization::Tra
 
     DeserializeStop(tc, tc_pb);
     DeserializeBus(tc, tc_pb);
+    // Bases written before the grid was stored get it built in Finalize
+    if (tc_pb.has_stop_grid()){
+        tc.SetStopGrid(DeserializeStopGrid(tc_pb.stop_grid()));
+    }
+    tc.Finalize();
 
     return std::move(tc);
 }
@@ -232,24 +313,37 @@ void DeserializeBus(tc::TransportCatalogue& tc, const tc_serialization::Transpor
    // Add all Buses
     for (size_t i = 0; i < tc_pb.bus_size(); ++i){
         vector<string_view> stops_for_bus;
-        if(tc_pb.bus(i).is_roundtrip()){
-            stops_for_bus.reserve(tc_pb.bus(i).route_stop_size());
-        } else{
-            stops_for_bus.reserve(tc_pb.bus(i).route_stop_size() * 2 - 1);
-        }
+        stops_for_bus.reserve(tc_pb.bus(i).route_stop_size());
         for (size_t j = 0; j < tc_pb.bus(i).route_stop_size(); ++j){
             stops_for_bus.push_back(tc_pb.bus(i).route_stop(j));
         }
-        if (!tc_pb.bus(i).is_roundtrip()){
-            size_t size = tc_pb.bus(i).route_stop_size();
-            for (size_t j = 1; j < size; ++j){
-                stops_for_bus.push_back(tc_pb.bus(i).route_stop(size - 1 - j));
-            }
-        }
 
-        tc.AddBus(tc_pb.bus(i).name(), stops_for_bus, tc_pb.bus(i).is_roundtrip());
+        // Bases written before statistics were stored have them empty
+        if (tc_pb.bus(i).statistics().stops() != 0){
+            tc.AddBus(tc_pb.bus(i).name(), stops_for_bus, tc_pb.bus(i).is_roundtrip(),
+                      DeserializeRouteStatistics(tc_pb.bus(i).statistics()));
+        } else {
+            tc.AddBus(tc_pb.bus(i).name(), stops_for_bus, tc_pb.bus(i).is_roundtrip());
+        }
     }
 }
 
+tc::StopGrid DeserializeStopGrid(const tc_serialization::StopGrid& grid_pb){
+    tc::GridLayout layout{grid_pb.min_lat(), grid_pb.min_lng(), grid_pb.cell_lat(), grid_pb.cell_lng(),
+                          grid_pb.rows(), grid_pb.cols()};
+    return {layout, {grid_pb.cell_offset().begin(), grid_pb.cell_offset().end()},
+            {grid_pb.cell_stop().begin(), grid_pb.cell_stop().end()}};
+}
+
+tc::RouteStatistics DeserializeRouteStatistics(const tc_serialization::RouteStatistics& stat_pb){
+    tc::RouteStatistics stat;
+    stat.stops = stat_pb.stops();
+    stat.unique_stops = stat_pb.unique_stops();
+    stat.route_length = stat_pb.route_length();
+    stat.route_length_geo = stat_pb.route_length_geo();
+    stat.curvature = stat_pb.curvature();
+    return stat;
+}
+
 } // namespace serialization
 } // namespace tc
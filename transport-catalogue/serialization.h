@@ -20,29 +20,38 @@ namespace serialization {
 
 // Serialization
 void Serialize(const tc::TransportCatalogue& tc, const tc::renderer::RenderSettings& render_set,
-               const tc::router::RoutingSettings& routing_set, const std::string& filename);
+               const tc::router::RoutingSettings& routing_set, const tc::router::Landmarks& landmarks,
+               const std::string& filename);
 
 tc_serialization::TransportCatalogue SerializeTransportCatalogue(const tc::TransportCatalogue& tc);
 void SerializeStop(tc_serialization::TransportCatalogue& tc_pb, const tc::TransportCatalogue& tc);
 void SerializeBus(tc_serialization::TransportCatalogue& tc_pb, const tc::TransportCatalogue& tc);
+tc_serialization::RouteStatistics SerializeRouteStatistics(const tc::RouteStatistics& stat);
+tc_serialization::StopGrid SerializeStopGrid(const tc::TransportCatalogue& tc);
 
 tc_serialization::Color SerializeSVGColor(const svg::Color& from_color);
 tc_serialization::RenderSettings SerializeRenderSettings(const tc::renderer::RenderSettings& render_set);
 
 tc_serialization::RoutingSettings SerializeRoutingSettings(const tc::router::RoutingSettings& routing_set);
+tc_serialization::Landmarks SerializeLandmarks(const tc::router::Landmarks& landmarks);
 
 // Deserialization
-void Deserialize(tc::TransportCatalogue& tc, tc::renderer::RenderSettings& render_set,
-                 tc::router::RoutingSettings& routing_set, const std::string& filename);
+// Returns false and leaves the arguments unchanged if the file can not be read
+bool Deserialize(tc::TransportCatalogue& tc, tc::renderer::RenderSettings& render_set,
+                 tc::router::RoutingSettings& routing_set, tc::router::Landmarks& landmarks,
+                 const std::string& filename);
 
 tc::TransportCatalogue DeserializeTransportCatalogue(const tc_serialization::TransportCatalogue& tc_pb);
 void DeserializeStop(tc::TransportCatalogue& tc, const tc_serialization::TransportCatalogue& tc_pb);
 void DeserializeBus(tc::TransportCatalogue& tc, const tc_serialization::TransportCatalogue& tc_pb);
+tc::RouteStatistics DeserializeRouteStatistics(const tc_serialization::RouteStatistics& stat_pb);
+tc::StopGrid DeserializeStopGrid(const tc_serialization::StopGrid& grid_pb);
 
 tc::renderer::RenderSettings DeserializeRenderSettings(const tc_serialization::RenderSettings& render_set_pb);
 svg::Color DeserializeSVGColor(tc_serialization::Color color);
 
 tc::router::RoutingSettings DeserializeRoutingSettings(const tc_serialization::RoutingSettings& routing_set_pb);
+tc::router::Landmarks DeserializeLandmarks(const tc_serialization::Landmarks& landmarks_pb);
 
 } // namespace serialization
 } // namespace tc
@@ -47,7 +47,7 @@ void ParseStat(const TransportCatalogue& tc, const vector<string>& queries){
 namespace print{
 
 void PrintBus(const TransportCatalogue& tc, std::string_view bus_name){
-    RouteStatistics stat = tc.GetStatistics(bus_name);
+    const RouteStatistics& stat = tc.GetStatistics(bus_name);
     if (stat.stops == 0){
         cout << "Bus "s << bus_name << ": not found"s << endl;
         return;
@@ -71,8 +71,8 @@ void PrintStop(const TransportCatalogue& tc, std::string_view stop_name){
     }
 
     cout << "Stop "s << stop_name << ": buses"s;
-    for (auto bus_name : result.all_buses){
-        cout << " "s << bus_name;
+    for (auto bus_id : result.all_buses){
+        cout << " "s << tc.GetBusName(bus_id);
     }
     cout << endl;
 }
@@ -0,0 +1,82 @@
+#include "stop_grid.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace tc{
+
+StopGrid::StopGrid(const std::vector<double>& latitudes, const std::vector<double>& longitudes){
+    const size_t stop_count = latitudes.size();
+    if (stop_count == 0){
+        return;
+    }
+    const auto [min_lat, max_lat] = std::minmax_element(latitudes.begin(), latitudes.end());
+    const auto [min_lng, max_lng] = std::minmax_element(longitudes.begin(), longitudes.end());
+    const double lat_span = *max_lat - *min_lat;
+    const double lng_span = *max_lng - *min_lng;
+
+    // Square cells with the area of the bounding box split between stops,
+    // but not smaller than the longer side split between stops, so there are at most ~3 cells per stop
+    double cell_size = std::max(std::sqrt(lat_span * lng_span / stop_count), std::max(lat_span, lng_span) / stop_count);
+    if (cell_size == 0){
+        cell_size = 1;
+    }
+    layout_ = {*min_lat, *min_lng, cell_size, cell_size,
+               static_cast<uint32_t>(lat_span / cell_size) + 1, static_cast<uint32_t>(lng_span / cell_size) + 1};
+
+    // Counting sort of stops by cell, stops of every cell come out ordered by id
+    std::vector<size_t> stop_cells(stop_count);
+    cell_offsets_.assign(static_cast<size_t>(layout_.rows) * layout_.cols + 1, 0);
+    for (size_t i = 0; i < stop_count; ++i){
+        stop_cells[i] = static_cast<size_t>(GetRow(latitudes[i])) * layout_.cols + GetCol(longitudes[i]);
+        ++cell_offsets_[stop_cells[i] + 1];
+    }
+    for (size_t i = 1; i < cell_offsets_.size(); ++i){
+        cell_offsets_[i] += cell_offsets_[i - 1];
+    }
+    cell_stops_.resize(stop_count);
+    std::vector<size_t> next_position(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t i = 0; i < stop_count; ++i){
+        cell_stops_[next_position[stop_cells[i]]++] = static_cast<StopId>(i);
+    }
+}
+
+StopGrid::StopGrid(GridLayout layout, std::vector<size_t> cell_offsets, std::vector<StopId> cell_stops)
+    : layout_(layout)
+    , cell_offsets_(std::move(cell_offsets))
+    , cell_stops_(std::move(cell_stops)){
+    if (cell_offsets_.size() != static_cast<size_t>(layout_.rows) * layout_.cols + 1
+            || cell_offsets_.front() != 0 || cell_offsets_.back() != cell_stops_.size()
+            || !std::is_sorted(cell_offsets_.begin(), cell_offsets_.end())
+            || !(layout_.cell_lat > 0) || !(layout_.cell_lng > 0)){
+        throw std::invalid_argument("Stop grid tables do not match its layout");
+    }
+}
+
+size_t StopGrid::GetStopCount() const{
+    return cell_stops_.size();
+}
+
+const GridLayout& StopGrid::GetLayout() const{
+    return layout_;
+}
+
+const std::vector<size_t>& StopGrid::GetCellOffsets() const{
+    return cell_offsets_;
+}
+
+const std::vector<StopId>& StopGrid::GetCellStops() const{
+    return cell_stops_;
+}
+
+uint32_t StopGrid::GetRow(double lat) const{
+    const double row = std::floor((lat - layout_.min_lat) / layout_.cell_lat);
+    return static_cast<uint32_t>(std::clamp(row, 0.0, layout_.rows - 1.0));
+}
+
+uint32_t StopGrid::GetCol(double lng) const{
+    const double col = std::floor((lng - layout_.min_lng) / layout_.cell_lng);
+    return static_cast<uint32_t>(std::clamp(col, 0.0, layout_.cols - 1.0));
+}
+
+} // namespace tc
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "domain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace tc{
+
+// Position and size of the grid cells in degrees
+struct GridLayout{
+    double min_lat = 0;
+    double min_lng = 0;
+    double cell_lat = 1;
+    double cell_lng = 1;
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+};
+
+// Uniform latitude/longitude grid over stops with about one stop per cell.
+// Stops of the cell with index c = row * cols + col are
+// cell_stops_[cell_offsets_[c] .. cell_offsets_[c + 1]), ordered by id.
+class StopGrid{
+public:
+    StopGrid() = default;
+    StopGrid(const std::vector<double>& latitudes, const std::vector<double>& longitudes);
+    // Restores the grid built earlier, throws std::invalid_argument if the tables do not match the layout
+    StopGrid(GridLayout layout, std::vector<size_t> cell_offsets, std::vector<StopId> cell_stops);
+
+    // Calls visit(stop_id) for every stop of the cells which intersect the box.
+    // Some of the stops may lie outside the box, the caller checks them.
+    template <typename Visitor>
+    void VisitBox(double min_lat, double max_lat, double min_lng, double max_lng, Visitor&& visit) const;
+
+    size_t GetStopCount() const;
+    const GridLayout& GetLayout() const;
+    const std::vector<size_t>& GetCellOffsets() const;
+    const std::vector<StopId>& GetCellStops() const;
+
+private:
+    GridLayout layout_;
+    std::vector<size_t> cell_offsets_{0};
+    std::vector<StopId> cell_stops_;
+
+    uint32_t GetRow(double lat) const;
+    uint32_t GetCol(double lng) const;
+};
+
+template <typename Visitor>
+void StopGrid::VisitBox(double min_lat, double max_lat, double min_lng, double max_lng, Visitor&& visit) const{
+    if (cell_stops_.empty()
+            || max_lat < layout_.min_lat || min_lat > layout_.min_lat + layout_.cell_lat * layout_.rows
+            || max_lng < layout_.min_lng || min_lng > layout_.min_lng + layout_.cell_lng * layout_.cols){
+        return;
+    }
+    const uint32_t last_row = GetRow(max_lat);
+    const uint32_t first_col = GetCol(min_lng);
+    const uint32_t last_col = GetCol(max_lng);
+    for (uint32_t row = GetRow(min_lat); row <= last_row; ++row){
+        // Cells of one row are adjacent, so their stops are one slice
+        const size_t first_cell = static_cast<size_t>(row) * layout_.cols + first_col;
+        const size_t last_cell = static_cast<size_t>(row) * layout_.cols + last_col;
+        for (size_t i = cell_offsets_[first_cell]; i < cell_offsets_[last_cell + 1]; ++i){
+            visit(cell_stops_[i]);
+        }
+    }
+}
+
+} // namespace tc
@@ -0,0 +1,55 @@
+#include "string_pool.h"
+
+#include <cstring>
+
+namespace tc{
+
+StringPool::Id StringPool::Intern(std::string_view str){
+    if (const auto it = index_.find(str); it != index_.end()){
+        return it->second;
+    }
+    const Id id = static_cast<Id>(strings_.size());
+    const std::string_view stored = Store(str);
+    strings_.push_back(stored);
+    index_.emplace(stored, id);
+    return id;
+}
+
+std::optional<StringPool::Id> StringPool::Find(std::string_view str) const{
+    if (const auto it = index_.find(str); it != index_.end()){
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::string_view StringPool::Get(Id id) const{
+    return strings_.at(id);
+}
+
+size_t StringPool::Size() const{
+    return strings_.size();
+}
+
+std::string_view StringPool::Store(std::string_view str){
+    if (str.empty()){
+        return {};
+    }
+    // Long strings get a block of their own, so the rest of the current block is not wasted
+    if (str.size() > BLOCK_SIZE / 4){
+        blocks_.push_back(std::make_unique<char[]>(str.size()));
+        std::memcpy(blocks_.back().get(), str.data(), str.size());
+        return {blocks_.back().get(), str.size()};
+    }
+    if (free_size_ < str.size()){
+        blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+        free_begin_ = blocks_.back().get();
+        free_size_ = BLOCK_SIZE;
+    }
+    std::memcpy(free_begin_, str.data(), str.size());
+    const std::string_view stored(free_begin_, str.size());
+    free_begin_ += str.size();
+    free_size_ -= str.size();
+    return stored;
+}
+
+} // namespace tc
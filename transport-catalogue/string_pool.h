@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tc{
+
+// Keeps one copy of every distinct string. Strings are copied into large blocks
+// which are never moved or freed before the pool, so ids and views handed out
+// stay valid for the pool's lifetime (moving the pool keeps them valid as well).
+class StringPool{
+public:
+    using Id = uint32_t;
+
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&&) = default;
+
+    // Id of the stored copy of str, the string is copied only when it is met for the first time
+    Id Intern(std::string_view str);
+    std::optional<Id> Find(std::string_view str) const;
+    std::string_view Get(Id id) const;
+    size_t Size() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* free_begin_ = nullptr;
+    size_t free_size_ = 0;
+
+    std::vector<std::string_view> strings_;
+    std::unordered_map<std::string_view, Id> index_;
+
+    std::string_view Store(std::string_view str);
+};
+
+} // namespace tc
@@ -1,16 +1,28 @@
 #include "svg.h"
+#include "char_scan.h"
+#include "number_format.h"
 
 namespace svg {
 
 using namespace std::literals;
 
+namespace {
+
+void RenderCoordinate(const RenderContext& context, double value){
+    number_format::PrintDouble(context.out, value, context.precision);
+}
+
+} // namespace
+
 std::ostream& operator<< (std::ostream& out, const svg::Rgb& color){
     out << "rgb("sv << color.red << ","sv << color.green << ","sv << color.blue << ")"sv;
     return out;
 }
 
 std::ostream& operator<< (std::ostream& out, const svg::Rgba& color){
-    out << "rgba("sv << color.red << ","sv << color.green << ","sv << color.blue << ","sv << color.opacity << ")"sv;
+    out << "rgba("sv << color.red << ","sv << color.green << ","sv << color.blue << ","sv;
+    number_format::PrintDouble(out, color.opacity);
+    out << ")"sv;
     return out;
 }
 
@@ -59,8 +71,13 @@ Circle& Circle::SetRadius(double radius)  {
 
 void Circle::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
-    out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\""sv;
-    out << " r=\""sv << radius_ << "\""sv;
+    out << "<circle cx=\""sv;
+    RenderCoordinate(context, center_.x);
+    out << "\" cy=\""sv;
+    RenderCoordinate(context, center_.y);
+    out << "\" r=\""sv;
+    number_format::PrintDouble(out, radius_);
+    out << "\""sv;
     //    PathProps
     RenderAttrs(context.out);
     out << "/>"sv;
@@ -81,7 +98,9 @@ void Polyline::RenderObject(const RenderContext& context) const {
         if(!is_first){
             out << " "sv;
         }
-        out << point.x << ","sv << point.y;
+        RenderCoordinate(context, point.x);
+        out << ","sv;
+        RenderCoordinate(context, point.y);
         is_first = false;
     }
     out << "\""sv;
@@ -129,8 +148,15 @@ Text& Text::SetData(std::string data){
 
 void Text::RenderObject(const RenderContext& context) const{
     auto& out = context.out;
-    out << "<text x=\""sv << pos_.x << "\" y=\""sv << pos_.y << "\""sv;
-    out << " dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y << "\""sv;
+    out << "<text x=\""sv;
+    RenderCoordinate(context, pos_.x);
+    out << "\" y=\""sv;
+    RenderCoordinate(context, pos_.y);
+    out << "\" dx=\""sv;
+    RenderCoordinate(context, offset_.x);
+    out << "\" dy=\""sv;
+    RenderCoordinate(context, offset_.y);
+    out << "\""sv;
     if (font_size_ != 0){
         out << " font-size=\""sv << font_size_ << "\""sv;
     }
@@ -143,26 +169,36 @@ void Text::RenderObject(const RenderContext& context) const{
     //    PathProps
     RenderAttrs(context.out);
     out << ">"sv;
-    for(const auto& c : data_){
-        if (c == '\"'){
+    // Runs of chars which need no escaping are written as a whole
+    const char* pos = data_.data();
+    const char* const end = pos + data_.size();
+    while (true) {
+        const char* special = char_scan::FindAnyOf<'\"', '\'', '<', '>', '&'>(pos, end);
+        out.write(pos, special - pos);
+        if (special == end) {
+            break;
+        }
+        if (*special == '\"'){
             out << "&quot;"sv;
-        } else if (c == '\''){
+        } else if (*special == '\''){
             out << "&apos;"sv;
-        } else if (c == '<'){
+        } else if (*special == '<'){
             out << "&lt;"sv;
-        } else if (c == '>'){
+        } else if (*special == '>'){
             out << "&gt;"sv;
-        } else if (c == '&'){
-            out << "&amp;"sv;
         } else {
-            out << c;
+            out << "&amp;"sv;
         }
-
+        pos = special + 1;
     }
     out << "</text>"sv;
 }
 
 // ---------- Document ------------------
+void Document::SetPrecision(int precision){
+    precision_ = precision;
+}
+
 void Document::AddPtr(std::unique_ptr<Object>&& obj){
     objects_.emplace_back(std::move(obj));
 }
@@ -172,6 +208,7 @@ void Document::Render(std::ostream& out) const{
     out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << "\n";
     out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << "\n";
     RenderContext context(out, 2, 2);
+    context.precision = precision_;
     for(const auto& obj : objects_){
         obj->Render(context);
     }
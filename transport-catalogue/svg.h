@@ -1,5 +1,7 @@
 #pragma once
 
+#include "number_format.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -64,7 +66,9 @@ struct RenderContext {
     }
 
     RenderContext Indented() const {
-        return {out, indent_step, indent + indent_step};
+        RenderContext result{out, indent_step, indent + indent_step};
+        result.precision = precision;
+        return result;
     }
 
     void RenderIndent() const {
@@ -76,6 +80,8 @@ struct RenderContext {
     std::ostream& out;
     int indent_step = 0;
     int indent = 0;
+    // Digits after the point in coordinates, negative gives the shortest exact text
+    int precision = -1;
 };
 
 enum class StrokeLineCap {
@@ -155,7 +161,9 @@ protected:
             out << " stroke=\""sv << *stroke_color_ << "\""sv;
         }
         if (width_){
-            out << " stroke-width=\""sv << *width_ << "\""sv;
+            out << " stroke-width=\""sv;
+            number_format::PrintDouble(out, *width_);
+            out << "\""sv;
         }
         if (line_cap_){
             out << " stroke-linecap=\""sv << *line_cap_ << "\""sv;
@@ -288,8 +296,12 @@ public:
 
     //   ostream svg- 
     void Render(std::ostream& out) const;
+
+    // Coordinates are rounded to precision digits after the point, negative gives the shortest exact text
+    void SetPrecision(int precision);
 private:
     std::vector<std::unique_ptr<Object>> objects_;
+    int precision_ = -1;
 
 };
 
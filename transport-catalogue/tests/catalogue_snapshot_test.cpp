@@ -0,0 +1,64 @@
+// Many threads answer stat requests from one CatalogueSnapshot and its router without locks,
+// every answer has to equal the one given by a single thread
+#include "test_utils.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int GRID_SIZE = 8;
+constexpr size_t THREAD_COUNT = 8;
+constexpr int ROUNDS = 3;
+
+void TestConcurrentReads() {
+    const tc::CatalogueSnapshot catalogue = tc_test::MakeGridCatalogue(GRID_SIZE).Freeze();
+    const tc::router::Router router({2, 30}, catalogue);
+    const tc::renderer::MapRenderer renderer(tc_test::MakeRenderSettings());
+    const json::Document requests = tc_test::MakeGridRequests(GRID_SIZE);
+    const json::Array& request_list = requests.GetRoot().AsArray();
+
+    std::vector<std::string> expected;
+    for (const json::Node& request : request_list) {
+        expected.push_back(tc_test::Answer(*catalogue, renderer, router, request));
+    }
+
+    std::atomic<size_t> mismatches = 0;
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < THREAD_COUNT; ++thread) {
+        threads.emplace_back([&, thread]() {
+            // Every thread starts at its own request, so different requests run at the same time
+            for (int round = 0; round < ROUNDS; ++round) {
+                for (size_t i = 0; i < request_list.size(); ++i) {
+                    const size_t index = (i + thread * 7) % request_list.size();
+                    if (tc_test::Answer(*catalogue, renderer, router, request_list[index]) != expected[index]) {
+                        ++mismatches;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    tc_test::Check(mismatches == 0, "answers from many threads equal the single thread ones");
+}
+
+void TestSnapshotOutlivesCatalogue() {
+    // The router shares ownership of the snapshot, so it stays valid when the other owners are gone
+    tc::CatalogueSnapshot catalogue = tc_test::MakeGridCatalogue(GRID_SIZE).Freeze();
+    const tc::router::Router router({2, 30}, std::move(catalogue));
+    const auto route = router.FindRoute(tc_test::GridStopName(0, 0), tc_test::GridStopName(GRID_SIZE - 1, GRID_SIZE - 1));
+    tc_test::Check(route.has_value() && !route->edges.empty(), "route found through a snapshot owned by the router");
+}
+
+} // namespace
+
+int main() {
+    TestConcurrentReads();
+    TestSnapshotOutlivesCatalogue();
+    std::cout << "catalogue_snapshot_test OK" << std::endl;
+}
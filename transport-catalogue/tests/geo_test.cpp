@@ -0,0 +1,80 @@
+// Batch distances of geo::ComputeDistances are within 1e-6 relative error of geo::ComputeDistance,
+// for points all over the globe and for stops from a few meters to a few kilometers apart
+#include "geo.h"
+#include "test_utils.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr double MAX_RELATIVE_ERROR = 1e-6;
+
+bool IsClose(double expected, double actual) {
+    if (expected == 0) {
+        return actual == 0;
+    }
+    return std::abs(actual - expected) <= MAX_RELATIVE_ERROR * expected;
+}
+
+// Points near a center, spread by up to spread degrees, and some of them repeated
+std::vector<tc::geo::Coordinates> MakePoints(std::mt19937& generator, tc::geo::Coordinates center, double spread, size_t count) {
+    std::uniform_real_distribution<double> offset(-spread, spread);
+    std::vector<tc::geo::Coordinates> points;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 17 == 16) {
+            points.push_back(points[i / 2]);
+        } else {
+            points.push_back({center.lat + offset(generator), center.lng + offset(generator)});
+        }
+    }
+    return points;
+}
+
+void CheckBatches(const std::vector<tc::geo::Coordinates>& points, std::mt19937& generator) {
+    tc::geo::PointTable table;
+    for (const auto& point : points) {
+        table.Add(point);
+    }
+    std::uniform_int_distribution<uint32_t> index(0, static_cast<uint32_t>(points.size() - 1));
+    std::vector<uint32_t> from;
+    std::vector<uint32_t> to;
+    // Odd count, so the pairs left after the ones computed at once are checked too
+    for (size_t i = 0; i < 20001; ++i) {
+        from.push_back(index(generator));
+        to.push_back(i % 5 == 0 ? from.back() : index(generator));
+    }
+
+    std::vector<double> distances(from.size());
+    tc::geo::ComputeDistances(table, from.data(), to.data(), from.size(), distances.data());
+    for (size_t i = 0; i < from.size(); ++i) {
+        const double expected = tc::geo::ComputeDistance(points[from[i]], points[to[i]]);
+        tc_test::Check(IsClose(expected, distances[i]), "distance between two points of the table");
+    }
+
+    const tc::geo::Coordinates center = points[index(generator)];
+    tc::geo::ComputeDistances(center, table, to.data(), to.size(), distances.data());
+    for (size_t i = 0; i < to.size(); ++i) {
+        const double expected = tc::geo::ComputeDistance(center, points[to[i]]);
+        tc_test::Check(IsClose(expected, distances[i]), "distance from a point to the points of the table");
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 generator(42);
+    // The whole globe, including nearly antipodal points
+    CheckBatches(MakePoints(generator, {0, 0}, 90, 2000), generator);
+    CheckBatches(MakePoints(generator, {0, 0}, 180, 2000), generator);
+    // A city, stops a few kilometers apart
+    CheckBatches(MakePoints(generator, {55.75, 37.62}, 0.1, 2000), generator);
+    // Stops a few meters to a few hundred meters apart
+    CheckBatches(MakePoints(generator, {55.75, 37.62}, 0.003, 2000), generator);
+    CheckBatches(MakePoints(generator, {-33.87, 151.21}, 0.0001, 2000), generator);
+    // Near the poles and the date line
+    CheckBatches(MakePoints(generator, {89.5, 179.5}, 0.5, 2000), generator);
+    std::cout << "geo_test OK" << std::endl;
+}
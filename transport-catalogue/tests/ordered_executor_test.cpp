@@ -0,0 +1,127 @@
+// The consumer of OrderedExecutor gets the results in the submit order whatever the order tasks finish in,
+// and a task that throws stops the results at it
+#include "ordered_executor.h"
+#include "test_utils.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t THREAD_COUNT = 8;
+constexpr size_t TASK_COUNT = 3000;
+
+// Tasks take different time, so they finish out of order
+parallel::OrderedExecutor::Task MakeTask(size_t index) {
+    return [index]() {
+        std::this_thread::sleep_for(std::chrono::microseconds((index * 7919) % 200));
+        return std::to_string(index);
+    };
+}
+
+// Collects the results and checks the consumer is never called by two threads at once
+class Collector {
+public:
+    parallel::OrderedExecutor::Consumer GetConsumer() {
+        return [this](std::string_view result) {
+            if (is_consuming_.exchange(true)) {
+                is_overlapped_ = true;
+            }
+            results_.emplace_back(result);
+            is_consuming_ = false;
+        };
+    }
+
+    // Results are 0, 1, ... count - 1
+    bool IsSequence(size_t count) const {
+        if (is_overlapped_ || results_.size() != count) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (results_[i] != std::to_string(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::atomic<bool> is_consuming_ = false;
+    std::atomic<bool> is_overlapped_ = false;
+    std::vector<std::string> results_;
+};
+
+void TestOrder(size_t thread_count, size_t max_pending) {
+    Collector collector;
+    parallel::OrderedExecutor executor(thread_count, collector.GetConsumer(), max_pending);
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        executor.Submit(MakeTask(i));
+    }
+    executor.Finish();
+    tc_test::Check(collector.IsSequence(TASK_COUNT), "results are consumed in the submit order");
+}
+
+void TestDestructorWaits() {
+    Collector collector;
+    {
+        parallel::OrderedExecutor executor(THREAD_COUNT, collector.GetConsumer());
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            executor.Submit(MakeTask(i));
+        }
+    }
+    tc_test::Check(collector.IsSequence(TASK_COUNT), "destructor consumes the submitted tasks");
+}
+
+// Task failed_index throws: the results before it are consumed, none after it,
+// and Submit or Finish rethrows. Returns the number of tasks after the failed one that ran
+size_t TestException(size_t thread_count, size_t failed_index) {
+    Collector collector;
+    std::atomic<size_t> later_runs = 0;
+    bool is_thrown = false;
+    {
+        parallel::OrderedExecutor executor(thread_count, collector.GetConsumer(), 16);
+        try {
+            for (size_t i = 0; i < TASK_COUNT; ++i) {
+                executor.Submit([i, failed_index, &later_runs]() {
+                    if (i == failed_index) {
+                        throw std::runtime_error("task failed");
+                    }
+                    if (i > failed_index) {
+                        ++later_runs;
+                    }
+                    return MakeTask(i)();
+                });
+            }
+            executor.Finish();
+        } catch (const std::runtime_error& e) {
+            is_thrown = std::string_view(e.what()) == "task failed";
+        }
+    }
+    tc_test::Check(is_thrown, "the exception of the task is rethrown");
+    tc_test::Check(collector.IsSequence(failed_index), "only the results before the failed task are consumed");
+    return later_runs;
+}
+
+} // namespace
+
+int main() {
+    TestOrder(THREAD_COUNT, 0);
+    // Submit waits for the consumer most of the time
+    TestOrder(THREAD_COUNT, 4);
+    TestOrder(1, 0);
+    // Treated as one thread
+    TestOrder(0, 0);
+    TestDestructorWaits();
+
+    TestException(THREAD_COUNT, 0);
+    TestException(THREAD_COUNT, 777);
+    TestException(THREAD_COUNT, TASK_COUNT - 1);
+    // One worker takes the tasks in order, so nothing after the failed task is run
+    tc_test::Check(TestException(1, 100) == 0, "tasks after the failed one are dropped");
+    std::cout << "ordered_executor_test OK" << std::endl;
+}
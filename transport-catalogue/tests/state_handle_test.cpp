@@ -0,0 +1,141 @@
+// Readers take the state from a StateHandle while another thread publishes new ones,
+// and Reload publishes a base read from a file or keeps the state when it can not be read
+#include "catalogue_service.h"
+#include "serialization.h"
+#include "test_utils.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t READER_COUNT = 6;
+constexpr uint64_t VERSION_COUNT = 40;
+
+const tc::router::RoutingSettings ROUTING_SETTINGS{2, 30};
+
+// Every version has its own grid size, so a reader can tell which base the state was built from
+int GridSizeOf(uint64_t version) {
+    return 2 + static_cast<int>(version % 4);
+}
+
+tc::service::StatePtr MakeGridState(uint64_t version) {
+    return tc::service::MakeState(tc_test::MakeGridCatalogue(GridSizeOf(version)), tc_test::MakeRenderSettings(),
+                                  ROUTING_SETTINGS, {}, version);
+}
+
+// The catalogue and the router of the state belong to the base of its version
+bool IsConsistent(const tc::service::ServiceState& state) {
+    const int size = GridSizeOf(state.version);
+    if (state.catalogue->GetStopCount() != static_cast<size_t>(size * size)) {
+        return false;
+    }
+    const auto route = state.router->FindRoute(tc_test::GridStopName(0, 0), tc_test::GridStopName(size - 1, size - 1));
+    return route.has_value() && !route->edges.empty();
+}
+
+void TestPublishWhileReading() {
+    tc::service::StateHandle handle(MakeGridState(0));
+    std::atomic<bool> is_published = false;
+    std::atomic<size_t> failures = 0;
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < READER_COUNT; ++i) {
+        readers.emplace_back([&]() {
+            uint64_t last_version = 0;
+            bool is_last = false;
+            while (!is_last) {
+                // Checked after the state is read, so the final version is seen at least once
+                is_last = is_published;
+                const tc::service::StatePtr state = handle.Acquire();
+                if (!state || state->version < last_version || !IsConsistent(*state)) {
+                    ++failures;
+                    return;
+                }
+                last_version = state->version;
+            }
+            if (last_version != VERSION_COUNT) {
+                ++failures;
+            }
+        });
+    }
+    for (uint64_t version = 1; version <= VERSION_COUNT; ++version) {
+        handle.Publish(MakeGridState(version));
+    }
+    is_published = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    tc_test::Check(failures == 0, "readers see consistent states with growing versions");
+}
+
+void TestHeldStateOutlivesPublish() {
+    tc::service::StateHandle handle(MakeGridState(1));
+    const tc::service::StatePtr held = handle.Acquire();
+    handle.Publish(MakeGridState(2));
+    tc_test::Check(held->version == 1 && IsConsistent(*held), "a held state stays valid after a publish");
+    tc_test::Check(handle.Acquire()->version == 2, "the published state is acquired");
+}
+
+void TestReload() {
+    const std::string filename = (std::filesystem::temp_directory_path() / "state_handle_test.db").string();
+    {
+        const tc::service::StatePtr state = MakeGridState(3);
+        tc::serialization::Serialize(*state->catalogue, tc_test::MakeRenderSettings(), ROUTING_SETTINGS,
+                                     state->router->GetLandmarks(), filename);
+    }
+
+    tc::service::StateHandle handle(MakeGridState(2));
+    tc_test::Check(!handle.Reload(filename + ".missing"), "reload of a missing base fails");
+    {
+        std::ofstream garbage(filename + ".bad", std::ios::binary);
+        garbage << "not a base";
+    }
+    tc_test::Check(!handle.Reload(filename + ".bad"), "reload of a broken base fails");
+    tc_test::Check(handle.Acquire()->version == 2, "failed reload keeps the state");
+
+    tc_test::Check(handle.Reload(filename), "reload of a serialized base");
+    const tc::service::StatePtr state = handle.Acquire();
+    // Version 3 has the grid size of the serialized base
+    tc_test::Check(state->version == 3 && IsConsistent(*state), "reloaded state gets the next version");
+
+    // Background loads run while the state is read, a load requested during another one is queued
+    {
+        tc::service::StateHandle async_handle(MakeGridState(0));
+        const tc::service::StatePtr held = async_handle.Acquire();
+        async_handle.ReloadAsync(filename);
+        async_handle.ReloadAsync(filename + ".missing");
+        async_handle.ReloadAsync(filename);
+        tc_test::Check(held->version == 0 && IsConsistent(*held), "state held during background loads");
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (async_handle.Acquire()->version < 2 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        tc_test::Check(async_handle.Acquire()->version == 2, "queued background loads are all published");
+    }
+    // The destructor does not wait for queued loads
+    {
+        tc::service::StateHandle async_handle(MakeGridState(0));
+        for (int i = 0; i < 100; ++i) {
+            async_handle.ReloadAsync(filename);
+        }
+    }
+    std::remove(filename.c_str());
+    std::remove((filename + ".bad").c_str());
+}
+
+} // namespace
+
+int main() {
+    TestPublishWhileReading();
+    TestHeldStateOutlivesPublish();
+    TestReload();
+    std::cout << "state_handle_test OK" << std::endl;
+}
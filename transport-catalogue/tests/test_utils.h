@@ -0,0 +1,121 @@
+#pragma once
+
+#include "json.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tc_test {
+
+// Stops the test with the message, in every build type unlike assert
+inline void Check(bool condition, std::string_view what) {
+    if (!condition) {
+        std::cerr << "Check failed: " << what << std::endl;
+        std::exit(1);
+    }
+}
+
+inline std::string GridStopName(int row, int column) {
+    return "Stop " + std::to_string(row) + "-" + std::to_string(column);
+}
+
+// size x size stops with road distances to the neighbours, a bus along every row
+// and a round trip bus along every column
+inline tc::TransportCatalogue MakeGridCatalogue(int size) {
+    tc::TransportCatalogue tc;
+    for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+            tc.AddStop(GridStopName(row, column), 55.5 + row * 0.01, 37.5 + column * 0.013);
+        }
+    }
+    for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+            if (column + 1 < size) {
+                tc.SetDistance(GridStopName(row, column), GridStopName(row, column + 1), 900 + (row * 7 + column * 3) % 400);
+            }
+            if (row + 1 < size) {
+                tc.SetDistance(GridStopName(row, column), GridStopName(row + 1, column), 1100 + (row * 5 + column * 11) % 300);
+                tc.SetDistance(GridStopName(row + 1, column), GridStopName(row, column), 1000 + (row * 13 + column) % 500);
+            }
+        }
+    }
+    for (int line = 0; line < size; ++line) {
+        std::vector<std::string> row_stops;
+        std::vector<std::string> column_stops;
+        for (int i = 0; i < size; ++i) {
+            row_stops.push_back(GridStopName(line, i));
+            column_stops.push_back(GridStopName(i, line));
+        }
+        // Down the column and back up, so the round trip only uses the set distances
+        for (int i = size - 2; i >= 0; --i) {
+            column_stops.push_back(GridStopName(i, line));
+        }
+        tc.AddBus("Row " + std::to_string(line), {row_stops.begin(), row_stops.end()}, false);
+        tc.AddBus("Column " + std::to_string(line), {column_stops.begin(), column_stops.end()}, true);
+    }
+    return tc;
+}
+
+inline tc::renderer::RenderSettings MakeRenderSettings() {
+    tc::renderer::RenderSettings settings;
+    settings.width = 600;
+    settings.height = 400;
+    settings.padding = 30;
+    settings.stop_radius = 5;
+    settings.line_width = 14;
+    settings.underlayer_color = std::string("white");
+    settings.underlayer_width = 3;
+    settings.color_palette = {std::string("green"), std::string("red"), svg::Rgb{255, 160, 0}};
+    return settings;
+}
+
+// Stat requests of every type for a catalogue made by MakeGridCatalogue, including unknown names
+inline json::Document MakeGridRequests(int size) {
+    std::ostringstream text;
+    int id = 0;
+    text << "[";
+    const auto add = [&text, &id](const std::string& fields) {
+        text << (id == 0 ? "" : ",") << "{\"id\": " << id << ", " << fields << "}";
+        ++id;
+    };
+    for (int line = 0; line < size; ++line) {
+        add("\"type\": \"Bus\", \"name\": \"Row " + std::to_string(line) + "\"");
+        add("\"type\": \"Bus\", \"name\": \"Column " + std::to_string(line) + "\"");
+        add("\"type\": \"Stop\", \"name\": \"" + GridStopName(line, size - 1 - line) + "\"");
+    }
+    add("\"type\": \"Bus\", \"name\": \"No bus\"");
+    add("\"type\": \"Stop\", \"name\": \"No stop\"");
+    for (int i = 0; i < size; ++i) {
+        const std::string from = GridStopName(i, 0);
+        const std::string to = GridStopName(size - 1 - i, size - 1);
+        add("\"type\": \"Route\", \"from\": \"" + from + "\", \"to\": \"" + to + "\"");
+        add("\"type\": \"Route\", \"from\": \"" + from + "\", \"to\": \"" + to + "\", \"alternatives\": 3");
+        add("\"type\": \"ParetoRoute\", \"from\": \"" + from + "\", \"to\": \"" + to + "\"");
+    }
+    add("\"type\": \"Nearby\", \"lat\": 55.52, \"lng\": 37.52, \"radius\": 2000");
+    add("\"type\": \"NearestStops\", \"lat\": 55.53, \"lng\": 37.51, \"count\": 5");
+    add("\"type\": \"Map\"");
+    text << "]";
+    return json::Load(text.str());
+}
+
+// Answer text of one stat request
+inline std::string Answer(const tc::TransportCatalogue& tc, const tc::renderer::MapRenderer& renderer,
+                          const tc::router::Router& router, const json::Node& request) {
+    std::ostringstream output;
+    json::Writer writer(output);
+    tc::reader::handler::GetStatAnswer(tc, request.AsDict(), renderer, writer, router);
+    writer.Flush();
+    return output.str();
+}
+
+} // namespace tc_test
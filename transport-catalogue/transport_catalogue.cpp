@@ -1,118 +1,372 @@
+#define _USE_MATH_DEFINES
 #include "transport_catalogue.h"
 
 using namespace std;
 
+#include <algorithm>
+#include <cmath>
 #include <cassert>
 #include <iostream>
+#include <set>
+#include <stdexcept>
+#include <tuple>
 
 namespace tc{
 
-void TransportCatalogue::AddStop(const std::string& name, double latitude, double longitude){
-    stops_.push_back({name, {latitude, longitude} });
-    stopname_to_stop_.insert({stops_.back().name, &(stops_.back())});
+StringPool::Id TransportCatalogue::InternName(std::string_view name){
+    const StringPool::Id name_id = names_.Intern(name);
+    if (name_id == name_to_stop_.size()){
+        name_to_stop_.push_back(NO_ID);
+        name_to_bus_.push_back(NO_ID);
+    }
+    return name_id;
+}
+
+void TransportCatalogue::AddStop(std::string_view name, double latitude, double longitude){
+    assert(!finalized_);
+    const StringPool::Id name_id = InternName(name);
+    // Lookup by name finds the first stop added with it
+    if (name_to_stop_[name_id] == NO_ID){
+        name_to_stop_[name_id] = static_cast<StopId>(stop_name_ids_.size());
+    }
+    stop_name_ids_.push_back(name_id);
+    stop_points_.Add({latitude, longitude});
+}
+
+void TransportCatalogue::AddBus(std::string_view name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip){
+    AddBusRoute(name, stops_for_bus, is_roundtrip);
+    // Empty statistics are computed in Finalize
+    bus_statistics_.emplace_back();
+}
+
+void TransportCatalogue::AddBus(std::string_view name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip,
+                                const RouteStatistics& statistics){
+    AddBusRoute(name, stops_for_bus, is_roundtrip);
+    bus_statistics_.push_back(statistics);
+}
+
+BusId TransportCatalogue::AddBusRoute(std::string_view name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip){
+    assert(!finalized_);
+    const BusId bus_id = static_cast<BusId>(bus_name_ids_.size());
+    const StringPool::Id name_id = InternName(name);
+    if (name_to_bus_[name_id] == NO_ID){
+        name_to_bus_[name_id] = bus_id;
+    }
+    bus_name_ids_.push_back(name_id);
+    bus_is_roundtrip_.push_back(is_roundtrip);
+    for (const auto stop : stops_for_bus){
+        route_stops_.push_back(GetStopId(stop));
+    }
+    route_offsets_.push_back(route_stops_.size());
+    return bus_id;
 }
 
-void TransportCatalogue::AddBus(const std::string& name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip){
-    Bus bus;
-    bus.name = name;
-    bus.stops.reserve(stops_for_bus.size());
-    bus.is_roundtrip = is_roundtrip;
+void TransportCatalogue::Finalize(){
+    assert(!finalized_);
+    finalized_ = true;
+    const size_t bus_count = bus_name_ids_.size();
+    const size_t stop_count = stop_name_ids_.size();
+
+    sorted_bus_ids_.resize(bus_count);
+    for (BusId id = 0; id < bus_count; ++id){
+        sorted_bus_ids_[id] = id;
+    }
+    std::sort(sorted_bus_ids_.begin(), sorted_bus_ids_.end(), [this](BusId lhs, BusId rhs){
+        return GetBusName(lhs) < GetBusName(rhs);
+    });
 
-    for(auto& stop : stops_for_bus){
-        bus.stops.push_back(stopname_to_stop_.at(stop));
+    sorted_stop_ids_.resize(stop_count);
+    for (StopId id = 0; id < stop_count; ++id){
+        sorted_stop_ids_[id] = id;
+    }
+    std::sort(sorted_stop_ids_.begin(), sorted_stop_ids_.end(), [this](StopId lhs, StopId rhs){
+        return GetStopName(lhs) < GetStopName(rhs);
+    });
+    stop_ranks_.resize(stop_count);
+    for (size_t i = 0; i < stop_count; ++i){
+        stop_ranks_[sorted_stop_ids_[i]] = i;
     }
 
-    buses_.emplace_back(move(bus));// move
-    busname_to_bus_.insert({buses_.back().name, &(buses_.back())});
+    const auto& grid_stops = stop_grid_.GetCellStops();
+    if (stop_grid_.GetStopCount() != stop_count
+            || std::any_of(grid_stops.begin(), grid_stops.end(), [stop_count](StopId id){ return id >= stop_count; })){
+        stop_grid_ = StopGrid(stop_points_.lat, stop_points_.lng);
+    }
 
-    for(auto& stop : stops_for_bus){
-        stopptr_to_buses_[stopname_to_stop_.at(stop)].insert(buses_.back().name);
+    BuildRoadDistances();
+    bus_distances_.resize(bus_count);
+    for (BusId id = 0; id < bus_count; ++id){
+        bus_distances_[id] = ComputeBusDistances(GetBusRoute(id));
+        if (bus_statistics_[id].stops == 0){
+            bus_statistics_[id] = ComputeStatistics(id);
+        }
+    }
+
+    // Two passes over the routes: count buses of every stop, then fill the ids.
+    // Buses are visited in name order, so ids of every stop come out sorted.
+    // The way back of a non-roundtrip route has no new stops, so only stored stops are visited.
+    std::vector<BusId> last_bus(stop_count, static_cast<BusId>(bus_count));
+    stop_bus_offsets_.assign(stop_count + 1, 0);
+    for (const BusId bus_id : sorted_bus_ids_){
+        for (const StopId stop_id : GetBusRoute(bus_id).GetStoredStops()){
+            if (last_bus[stop_id] != bus_id){
+                last_bus[stop_id] = bus_id;
+                ++stop_bus_offsets_[stop_id + 1];
+            }
+        }
+    }
+    for (size_t i = 1; i < stop_bus_offsets_.size(); ++i){
+        stop_bus_offsets_[i] += stop_bus_offsets_[i - 1];
+    }
+
+    stop_bus_ids_.resize(stop_bus_offsets_.back());
+    std::vector<size_t> next_position(stop_bus_offsets_.begin(), stop_bus_offsets_.end() - 1);
+    last_bus.assign(stop_count, static_cast<BusId>(bus_count));
+    for (const BusId bus_id : sorted_bus_ids_){
+        for (const StopId stop_id : GetBusRoute(bus_id).GetStoredStops()){
+            if (last_bus[stop_id] != bus_id){
+                last_bus[stop_id] = bus_id;
+                stop_bus_ids_[next_position[stop_id]++] = bus_id;
+            }
+        }
     }
 }
 
-std::set<std::string_view> TransportCatalogue::GetAllBusNames() const{
-    std::set<std::string_view> result;
-    for (const auto& [bus_name, _] : busname_to_bus_){
-        result.insert(bus_name);
+CatalogueSnapshot TransportCatalogue::Freeze() &&{
+    if (!finalized_){
+        Finalize();
     }
-    return result;
+    return std::make_shared<const TransportCatalogue>(std::move(*this));
 }
 
-bool TransportCatalogue::BusIsRoundtrip(std::string_view bus_name) const{
-    return busname_to_bus_.at(bus_name)->is_roundtrip;
+BusIdRange TransportCatalogue::GetAllBusIds() const{
+    return ranges::AsRange(sorted_bus_ids_);
+}
 
+std::string_view TransportCatalogue::GetName(StringPool::Id name_id) const{
+    return names_.Get(name_id);
 }
 
-const vector<Stop*>& TransportCatalogue::GetBusRoute(string_view bus_name) const{
-    if (busname_to_bus_.count(bus_name) != 0){
-        return busname_to_bus_.at(bus_name)->stops;
+std::optional<BusId> TransportCatalogue::FindBus(std::string_view bus_name) const{
+    if (const auto name_id = names_.Find(bus_name); name_id && name_to_bus_[*name_id] != NO_ID){
+        return name_to_bus_[*name_id];
     }
-    return dummy_stop;
+    return std::nullopt;
+}
+
+std::string_view TransportCatalogue::GetBusName(BusId bus_id) const{
+    return names_.Get(bus_name_ids_.at(bus_id));
 }
 
+StringPool::Id TransportCatalogue::GetBusNameId(BusId bus_id) const{
+    return bus_name_ids_.at(bus_id);
+}
+
+bool TransportCatalogue::BusIsRoundtrip(BusId bus_id) const{
+    return bus_is_roundtrip_.at(bus_id);
+}
+
+RouteView TransportCatalogue::GetBusRoute(BusId bus_id) const{
+    const size_t begin = route_offsets_.at(bus_id);
+    return {route_stops_.data() + begin, route_offsets_.at(bus_id + 1) - begin, bus_is_roundtrip_.at(bus_id)};
+}
 
-std::set<std::string_view> TransportCatalogue::GetAllStopNames() const{
-    std::set<std::string_view> result;
-    for (const auto& [stop_name, _] : stopname_to_stop_){
-        result.insert(stop_name);
+const BusDistances& TransportCatalogue::GetBusDistances(BusId bus_id) const{
+    return bus_distances_.at(bus_id);
+}
+
+StopIdRange TransportCatalogue::GetAllStopIds() const{
+    return ranges::AsRange(sorted_stop_ids_);
+}
+
+std::optional<StopId> TransportCatalogue::FindStop(std::string_view stop_name) const{
+    if (const auto name_id = names_.Find(stop_name); name_id && name_to_stop_[*name_id] != NO_ID){
+        return name_to_stop_[*name_id];
     }
-    return result;
+    return std::nullopt;
 }
-const Stop* TransportCatalogue::GetStopInfo(std::string_view stop_name) const{
-    if (stopname_to_stop_.count(stop_name) == 0){
-        return nullptr;
+
+StopId TransportCatalogue::GetStopId(std::string_view stop_name) const{
+    if (const auto stop_id = FindStop(stop_name)){
+        return *stop_id;
     }
-    return stopname_to_stop_.at(stop_name);
+    throw std::out_of_range("Unknown stop");
+}
+
+std::string_view TransportCatalogue::GetStopName(StopId stop_id) const{
+    return names_.Get(stop_name_ids_.at(stop_id));
+}
+
+StringPool::Id TransportCatalogue::GetStopNameId(StopId stop_id) const{
+    return stop_name_ids_.at(stop_id);
+}
+
+geo::Coordinates TransportCatalogue::GetStopCoordinates(StopId stop_id) const{
+    return stop_points_.Get(stop_id);
 }
 
 StopRequest TransportCatalogue::GetBusForStop (string_view stop_name) const{
     StopRequest result;
-    if (stopname_to_stop_.count(stop_name) != 0){
+    if (const auto stop_id = FindStop(stop_name)){
         result.have_stop = true;
-        if (stopptr_to_buses_.count(stopname_to_stop_.at(stop_name)) != 0){
-            result.all_buses = stopptr_to_buses_.at(stopname_to_stop_.at(stop_name));
+        result.all_buses = GetStopBuses(*stop_id);
+    }
+    return result;
+}
+
+bool TransportCatalogue::StopHaveBus(StopId stop_id) const{
+    return !GetStopBuses(stop_id).empty();
+}
+
+BusIdRange TransportCatalogue::GetStopBuses(StopId stop_id) const{
+    assert(stop_bus_offsets_.size() == stop_name_ids_.size() + 1);
+    return {stop_bus_ids_.begin() + stop_bus_offsets_[stop_id], stop_bus_ids_.begin() + stop_bus_offsets_[stop_id + 1]};
+}
+
+std::vector<NearbyStop> TransportCatalogue::FindStopsNearby(geo::Coordinates center, double radius) const{
+    std::vector<StopId> candidates;
+    const auto add_candidate = [&candidates](StopId stop_id){
+        candidates.push_back(stop_id);
+    };
+
+    // Bounding box of the spherical cap around the center
+    const double angle = radius / geo::EARTH_RADIUS;
+    const double lat_delta = angle * 180 / M_PI;
+    double lng_delta = 180;
+    if (angle < M_PI / 2 && std::abs(center.lat) + lat_delta < 90){
+        lng_delta = std::asin(std::sin(angle) / std::cos(center.lat * M_PI / 180)) * 180 / M_PI;
+    }
+    if (center.lng - lng_delta < -180 || center.lng + lng_delta > 180){
+        // The cap crosses the antimeridian, all longitudes are searched
+        lng_delta = 360;
+    }
+    stop_grid_.VisitBox(center.lat - lat_delta, center.lat + lat_delta,
+                        center.lng - lng_delta, center.lng + lng_delta, add_candidate);
+
+    std::vector<double> distances(candidates.size());
+    geo::ComputeDistances(center, stop_points_, candidates.data(), candidates.size(), distances.data());
+    std::vector<NearbyStop> result;
+    for (size_t i = 0; i < candidates.size(); ++i){
+        if (distances[i] <= radius){
+            result.push_back({candidates[i], distances[i]});
         }
     }
+    SortNearbyStops(result);
     return result;
 }
 
-bool TransportCatalogue::StopHaveBus(std::string_view stop_name) const{
-    return (stopptr_to_buses_.count(stopname_to_stop_.at(stop_name)) != 0);
+std::vector<NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates center, size_t count) const{
+    count = std::min(count, GetStopCount());
+    if (count == 0){
+        return {};
+    }
+    // The radius doubles until the circle holds enough stops: all stops nearer than
+    // the count-th one are inside the same circle, so the answer is exact
+    double radius = stop_grid_.GetLayout().cell_lat * M_PI / 180 * geo::EARTH_RADIUS;
+    while (true){
+        auto result = FindStopsNearby(center, radius);
+        if (result.size() >= count || radius > M_PI * geo::EARTH_RADIUS){
+            result.resize(std::min(count, result.size()));
+            return result;
+        }
+        radius *= 2;
+    }
+}
+
+void TransportCatalogue::SetStopGrid(StopGrid grid){
+    assert(!finalized_);
+    stop_grid_ = std::move(grid);
+}
+
+const StopGrid& TransportCatalogue::GetStopGrid() const{
+    return stop_grid_;
+}
+
+void TransportCatalogue::SortNearbyStops(std::vector<NearbyStop>& stops) const{
+    std::sort(stops.begin(), stops.end(), [this](const NearbyStop& lhs, const NearbyStop& rhs){
+        return std::tie(lhs.distance, stop_ranks_[lhs.stop_id]) < std::tie(rhs.distance, stop_ranks_[rhs.stop_id]);
+    });
 }
 
 void TransportCatalogue::SetDistance(std::string_view stopname_from, std::string_view stopname_to, int distance){
+    assert(!finalized_);
 //    cerr << stopname_from << " "s << stopname_to << " "s << distance << endl;
-    assert(!((stopname_to_stop_.count(stopname_from) == 0) || (stopname_to_stop_.count(stopname_to) == 0)));
-    pairstops_to_dist_[{stopname_to_stop_.at(stopname_from), stopname_to_stop_.at(stopname_to)}] = distance;
+    pending_distances_.emplace_back(GetStopId(stopname_from), GetStopId(stopname_to), distance);
 }
 
 int TransportCatalogue::GetDistance(std::string_view stopname_from, std::string_view stopname_to) const{
-    assert(!((stopname_to_stop_.count(stopname_from) == 0) || (stopname_to_stop_.count(stopname_to) == 0)));
-    return GetDistance(stopname_to_stop_.at(stopname_from), stopname_to_stop_.at(stopname_to));
+    return GetDistance(GetStopId(stopname_from), GetStopId(stopname_to));
 }
-int TransportCatalogue::GetDistance(Stop* stopptr_from, Stop* stopptr_to) const{
-    if (pairstops_to_dist_.count({stopptr_from, stopptr_to}) == 0){
-        return pairstops_to_dist_.at({stopptr_to, stopptr_from});
+int TransportCatalogue::GetDistance(StopId stop_from, StopId stop_to) const{
+    const auto find = [this](StopId from, StopId to) -> const RoadDistance*{
+        const auto distances = GetRoadDistances(from);
+        const auto it = std::lower_bound(distances.begin(), distances.end(), to, [](const RoadDistance& item, StopId id){
+            return item.to < id;
+        });
+        return it != distances.end() && it->to == to ? &*it : nullptr;
+    };
+    if (const RoadDistance* forward = find(stop_from, stop_to)){
+        return forward->distance;
+    }
+    if (const RoadDistance* backward = find(stop_to, stop_from)){
+        return backward->distance;
     }
-    return pairstops_to_dist_.at({stopptr_from, stopptr_to});
+    throw std::out_of_range("Distance between stops is not set");
+}
+
+RoadDistanceRange TransportCatalogue::GetRoadDistances(StopId stop_from) const{
+    assert(road_distance_offsets_.size() == stop_name_ids_.size() + 1);
+    return {road_distances_.begin() + road_distance_offsets_.at(stop_from),
+            road_distances_.begin() + road_distance_offsets_.at(stop_from + 1)};
 }
 
-RouteStatistics TransportCatalogue::GetStatistics(std::string_view bus_name) const{
+void TransportCatalogue::BuildRoadDistances(){
+    // The last of distances set for the same pair of stops wins
+    std::stable_sort(pending_distances_.begin(), pending_distances_.end(), [](const auto& lhs, const auto& rhs){
+        return std::tie(std::get<0>(lhs), std::get<1>(lhs)) < std::tie(std::get<0>(rhs), std::get<1>(rhs));
+    });
+    road_distance_offsets_.assign(stop_name_ids_.size() + 1, 0);
+    road_distances_.clear();
+    road_distances_.reserve(pending_distances_.size());
+    for (size_t i = 0; i < pending_distances_.size(); ++i){
+        const auto [from, to, distance] = pending_distances_[i];
+        if (i + 1 < pending_distances_.size() && std::get<0>(pending_distances_[i + 1]) == from
+                && std::get<1>(pending_distances_[i + 1]) == to){
+            continue;
+        }
+        road_distances_.push_back({to, distance});
+        ++road_distance_offsets_[from + 1];
+    }
+    for (size_t i = 1; i < road_distance_offsets_.size(); ++i){
+        road_distance_offsets_[i] += road_distance_offsets_[i - 1];
+    }
+    pending_distances_.clear();
+    pending_distances_.shrink_to_fit();
+}
+
+const RouteStatistics& TransportCatalogue::GetStatistics(std::string_view bus_name) const{
+    if (const auto bus_id = FindBus(bus_name)){
+        return bus_statistics_.at(*bus_id);
+    }
+    return dummy_statistics;
+}
+
+RouteStatistics TransportCatalogue::ComputeStatistics(BusId bus_id) const{
     RouteStatistics result;
-    const auto& route = GetBusRoute(bus_name);
+    const auto route = GetBusRoute(bus_id);
     if (route.size() == 0){
         return result;
     }
 
     result.stops = route.size();
 
-    set<Stop*> unique_stops(route.begin(), route.end());
+    const auto stored_stops = route.GetStoredStops();
+    set<StopId> unique_stops(stored_stops.begin(), stored_stops.end());
     result.unique_stops = unique_stops.size();
 
-    for (auto it = route.begin(); it < route.end() - 1; ++it){
-        result.route_length_geo += std::abs(ComputeDistance((*it)->coordinates, (*(it + 1))->coordinates));
-        result.route_length += GetDistance((*it)->name, (*(it+1))->name);
-    }
+    const auto& distances = bus_distances_.at(bus_id);
+    result.route_length_geo = distances.geo.back();
+    result.route_length = distances.road.back();
 
     result.curvature = result.route_length_geo != 0 ? result.route_length / result.route_length_geo : 0;
 
@@ -120,16 +374,37 @@ RouteStatistics TransportCatalogue::GetStatistics(std::string_view bus_name) con
 }
 
 size_t TransportCatalogue::GetStopCount() const{
-    return stopname_to_stop_.size();
+    return stop_name_ids_.size();
+}
+
+BusDistances TransportCatalogue::ComputeBusDistances(RouteView route) const{
+    BusDistances result;
+    result.road.reserve(route.size());
+    result.geo.reserve(route.size());
+    result.road.push_back(0);
+    result.geo.push_back(0);
+    if (route.empty()){
+        return result;
+    }
+
+    // Geographic lengths of all segments in one batch
+    std::vector<StopId> stops(route.begin(), route.end());
+    std::vector<double> segments(stops.size() - 1);
+    geo::ComputeDistances(stop_points_, stops.data(), stops.data() + 1, segments.size(), segments.data());
+
+    for (size_t i = 1; i < stops.size(); ++i){
+        result.road.push_back(result.road.back() + GetDistance(stops[i - 1], stops[i]));
+        result.geo.push_back(result.geo.back() + segments[i - 1]);
+    }
+    return result;
 }
 
-const TransportCatalogue::DistancesTable TransportCatalogue::GetDistancesTable() const{
-    return pairstops_to_dist_;
+double BusDistances::GetRoadDistance(size_t from_index, size_t to_index) const{
+    return road.at(to_index) - road.at(from_index);
 }
 
-size_t TransportCatalogue::StopToStopHasher::operator ()(const std::pair<Stop*, Stop*>& pairstops) const{
-    hash<Stop*> hasher_;
-    return static_cast<size_t>(hasher_(pairstops.first) + 1801 * hasher_(pairstops.second));
+double BusDistances::GetGeoDistance(size_t from_index, size_t to_index) const{
+    return geo.at(to_index) - geo.at(from_index);
 }
 
 } // namespace tc
@@ -1,11 +1,13 @@
 #pragma once
 
-#include <deque>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <optional>
-#include <set>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -13,13 +15,19 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "ranges.h"
+#include "stop_grid.h"
+#include "string_pool.h"
 
 namespace tc{
 
+using BusIdRange = ranges::Range<std::vector<BusId>::const_iterator>;
+using StopIdRange = ranges::Range<std::vector<StopId>::const_iterator>;
 
 struct StopRequest{
     bool have_stop = false;
-    std::set<std::string_view> all_buses;
+    // Ids of buses sorted by bus name, a view into the catalogue (see GetBusName)
+    BusIdRange all_buses{{}, {}};
 };
 
 struct RouteStatistics{
@@ -30,55 +38,157 @@ struct RouteStatistics{
     double curvature = 0;
 };
 
+// Distances along the route from its first stop, computed once in Finalize,
+// so the length of any part of the route is a difference of two values
+struct BusDistances{
+    std::vector<double> road;
+    std::vector<double> geo;
+
+    double GetRoadDistance(size_t from_index, size_t to_index) const;
+    double GetGeoDistance(size_t from_index, size_t to_index) const;
+};
+
+// Road distance from a stop to the stop with id "to"
+struct RoadDistance{
+    StopId to;
+    int distance;
+};
+
+using RoadDistanceRange = ranges::Range<std::vector<RoadDistance>::const_iterator>;
+
+// Stop found near a point and its distance from the point in meters
+struct NearbyStop{
+    StopId stop_id;
+    double distance;
+};
+
 enum class EdgeType{
     BUS,
     WAIT
 };
 
-class TransportCatalogue{
-public:
+class TransportCatalogue;
 
+// Finished catalogue shared between its readers.
+// Const member functions of TransportCatalogue only read its arrays and maps (there are no caches
+// filled on demand), so any number of threads may query a snapshot at once without locking.
+using CatalogueSnapshot = std::shared_ptr<const TransportCatalogue>;
 
-    void AddStop(const std::string& name, double latitude, double longitude);
-    void AddBus(const std::string& bus_name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip);
+class TransportCatalogue{
+public:
 
-    std::set<std::string_view> GetAllBusNames() const;
-    bool BusIsRoundtrip(std::string_view bus_name) const;
-    const std::vector<Stop*>& GetBusRoute(std::string_view bus_name) const;
 
-    std::set<std::string_view> GetAllStopNames() const;
-    const Stop* GetStopInfo(std::string_view stop_name) const;
+    // Base is filled with AddStop, SetDistance and AddBus, then Finalize (called once) builds
+    // the distance table, route distances and statistics and lookup indexes which all queries rely on.
+    // stops_for_bus are the stops as given in the request: the whole circle for a roundtrip bus,
+    // one way for the others.
+    // Names are copied into the catalogue's string pool, so the arguments may be views into the input.
+    void AddStop(std::string_view name, double latitude, double longitude);
+    void AddBus(std::string_view bus_name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip);
+    // Adds a bus with statistics computed earlier (e.g. restored from the base)
+    void AddBus(std::string_view bus_name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip,
+                const RouteStatistics& statistics);
+
+    void Finalize();
+    // Finalizes the catalogue if needed and moves it into an immutable snapshot
+    CatalogueSnapshot Freeze() &&;
+
+    // Names of stops and buses live in one pool: a stop and a bus with the same name share it.
+    // Returned views stay valid as long as the catalogue (or the one it is moved to) exists.
+    std::string_view GetName(StringPool::Id name_id) const;
+
+    // Ids of all buses sorted by bus name
+    BusIdRange GetAllBusIds() const;
+    std::optional<BusId> FindBus(std::string_view bus_name) const;
+    std::string_view GetBusName(BusId bus_id) const;
+    StringPool::Id GetBusNameId(BusId bus_id) const;
+    bool BusIsRoundtrip(BusId bus_id) const;
+    RouteView GetBusRoute(BusId bus_id) const;
+    const BusDistances& GetBusDistances(BusId bus_id) const;
+
+    // Ids of all stops sorted by stop name
+    StopIdRange GetAllStopIds() const;
+    std::optional<StopId> FindStop(std::string_view stop_name) const;
+    // The same for a stop which has to exist, throws std::out_of_range otherwise
+    StopId GetStopId(std::string_view stop_name) const;
+    std::string_view GetStopName(StopId stop_id) const;
+    StringPool::Id GetStopNameId(StopId stop_id) const;
+    geo::Coordinates GetStopCoordinates(StopId stop_id) const;
     StopRequest GetBusForStop(std::string_view stop_name) const;
-    bool StopHaveBus(std::string_view stop_name) const;
+    bool StopHaveBus(StopId stop_id) const;
+
+    // Stops not farther than radius meters from the point, ordered by distance and then by name
+    std::vector<NearbyStop> FindStopsNearby(geo::Coordinates center, double radius) const;
+    // Up to count stops nearest to the point, ordered by distance and then by name
+    std::vector<NearbyStop> FindNearestStops(geo::Coordinates center, size_t count) const;
+    // Finalize keeps the grid set before it (e.g. restored from the base) if it covers the same stops
+    void SetStopGrid(StopGrid grid);
+    const StopGrid& GetStopGrid() const;
 
     void SetDistance(std::string_view stopname_from, std::string_view stopname_to, int distance);
+    // Distance from one stop to another, the reverse one if it was not set.
+    // Throws std::out_of_range if neither was set.
     int GetDistance(std::string_view stopname_from, std::string_view stopname_to) const;
-    int GetDistance(Stop* stopptr_from, Stop* stopptr_to) const;
+    int GetDistance(StopId stop_from, StopId stop_to) const;
+    // Distances set from the stop, ordered by the id of the other stop
+    RoadDistanceRange GetRoadDistances(StopId stop_from) const;
 
-    RouteStatistics GetStatistics(std::string_view bus_name) const;
+    // Statistics are computed once in Finalize
+    const RouteStatistics& GetStatistics(std::string_view bus_name) const;
 
     size_t GetStopCount() const;
 
-    struct StopToStopHasher{
-        size_t operator() (const std::pair<Stop*, Stop*>& pairstops) const;
-    };
-
-    using DistancesTable =  std::unordered_map<std::pair<Stop*, Stop*>, int, StopToStopHasher>;
-
-    const DistancesTable GetDistancesTable() const;
-
 private:
-    std::deque<Stop> stops_;
-    std::unordered_map<std::string_view, Stop*> stopname_to_stop_;
-
-    std::deque<Bus> buses_;
-    std::unordered_map<std::string_view, Bus*> busname_to_bus_;
-
-    std::unordered_map<Stop*, std::set<std::string_view>> stopptr_to_buses_;
-
-    DistancesTable pairstops_to_dist_;
-
-    std::vector<Stop*> dummy_stop;
+    static constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
+
+    bool finalized_ = false;
+
+    StringPool names_;
+    // Stop or bus with the name, indexed by name id, NO_ID if there is none
+    std::vector<StopId> name_to_stop_;
+    std::vector<BusId> name_to_bus_;
+
+    // Stops and buses are kept as parallel arrays indexed by id
+    std::vector<StringPool::Id> stop_name_ids_;
+    geo::PointTable stop_points_;
+
+    std::vector<StringPool::Id> bus_name_ids_;
+    std::vector<bool> bus_is_roundtrip_;
+    // Stored stops of all routes in one array: stops of the bus with id i
+    // are route_stops_[route_offsets_[i] .. route_offsets_[i + 1])
+    std::vector<size_t> route_offsets_{0};
+    std::vector<StopId> route_stops_;
+    std::vector<BusDistances> bus_distances_;
+    std::vector<RouteStatistics> bus_statistics_;
+
+    // Buses of every stop in CSR form: ids of buses for the stop with id i
+    // are stop_bus_ids_[stop_bus_offsets_[i] .. stop_bus_offsets_[i + 1])
+    std::vector<size_t> stop_bus_offsets_;
+    std::vector<BusId> stop_bus_ids_;
+
+    std::vector<BusId> sorted_bus_ids_;
+    std::vector<StopId> sorted_stop_ids_;
+    // Position of every stop in sorted_stop_ids_
+    std::vector<size_t> stop_ranks_;
+
+    StopGrid stop_grid_;
+
+    // Distances as they were set, until Finalize moves them to the table below
+    std::vector<std::tuple<StopId, StopId, int>> pending_distances_;
+    // Distances in CSR form: distances from the stop with id i are
+    // road_distances_[road_distance_offsets_[i] .. road_distance_offsets_[i + 1]), sorted by "to"
+    std::vector<size_t> road_distance_offsets_;
+    std::vector<RoadDistance> road_distances_;
+
+    RouteStatistics dummy_statistics;
+
+    StringPool::Id InternName(std::string_view name);
+    BusId AddBusRoute(std::string_view bus_name, const std::vector<std::string_view>& stops_for_bus, bool is_roundtrip);
+    void BuildRoadDistances();
+    BusDistances ComputeBusDistances(RouteView route) const;
+    RouteStatistics ComputeStatistics(BusId bus_id) const;
+    BusIdRange GetStopBuses(StopId stop_id) const;
+    void SortNearbyStops(std::vector<NearbyStop>& stops) const;
 };
 
 } // namespace tc
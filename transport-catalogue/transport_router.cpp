@@ -1,17 +1,217 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+
 namespace tc{
 namespace router{
 
+namespace {
+
+// Building the edges of fewer buses takes less time than starting a thread
+constexpr size_t MIN_BUSES_PER_THREAD = 64;
+
+} // namespace
+
 Router::Router(RoutingSettings setting, const TransportCatalogue& tc)
+: settings_(setting),
+  tc_(tc),
+  tc_graph_(tc.GetStopCount() * 2){
+    BuildGraph();
+    ComputeLandmarks();
+}
+
+Router::Router(RoutingSettings setting, const TransportCatalogue& tc, Landmarks landmarks)
 : settings_(setting),
   tc_(tc),
   tc_graph_(tc.GetStopCount() * 2),
-  router_(ReturnInitializedGraph()){
+  landmarks_(std::move(landmarks)){
+    BuildGraph();
+    // Landmarks of another graph would give wrong lower bounds, e.g. for a base with other stops or distances
+    if (!landmarks_.IsComputedFor(tc_graph_)){
+        ComputeLandmarks();
+    }
+}
+
+Router::Router(RoutingSettings setting, CatalogueSnapshot catalogue, Landmarks landmarks)
+: Router(setting, *catalogue, std::move(landmarks)){
+    catalogue_ = std::move(catalogue);
 }
 
 std::optional<RouteInfo> Router::FindRoute(std::string_view stop_from, std::string_view stop_to) const{
-    return router_.BuildRoute(GetStopIndex(stop_from), GetStopIndex(stop_to));
+    const size_t to = GetStopIndex(stop_to);
+    return graph::FindShortestPath(tc_graph_, GetStopIndex(stop_from), to, [this, to](graph::VertexId vertex){
+        return landmarks_.LowerBound(vertex, to);
+    });
+}
+
+std::vector<ParetoRoute> Router::FindParetoRoutes(std::string_view stop_from, std::string_view stop_to) const{
+    struct Label{
+        double time;
+        int rides;
+        graph::VertexId vertex;
+        std::optional<graph::EdgeId> edge;
+        size_t parent;
+    };
+    // (time + lower bound, rides, label index): equally fast labels with fewer rides go first
+    using QueueItem = std::tuple<double, int, size_t>;
+
+    const graph::VertexId from = GetStopIndex(stop_from);
+    const graph::VertexId to = GetStopIndex(stop_to);
+    const size_t label_limit = static_cast<size_t>(std::max(settings_.pareto_label_limit, 1));
+    const auto lower_bound = [this, to](graph::VertexId vertex){
+        return landmarks_.LowerBound(vertex, to);
+    };
+
+    // Labels leave the queue in order of time + lower bound, so every permanent label of a vertex
+    // is at least as fast as the later ones and a new label is useful only with fewer rides
+    std::vector<Label> labels;
+    std::vector<int> min_rides(tc_graph_.GetVertexCount(), std::numeric_limits<int>::max());
+    std::vector<size_t> label_count(tc_graph_.GetVertexCount(), 0);
+    std::vector<size_t> result_labels;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    labels.push_back({0.0, 0, from, std::nullopt, 0});
+    queue.push({lower_bound(from), 0, 0});
+    while (!queue.empty() && result_labels.size() < label_limit){
+        const size_t label_index = std::get<2>(queue.top());
+        const Label label = labels[label_index];
+        queue.pop();
+        if (label.rides >= min_rides[label.vertex] || label.rides >= min_rides[to]
+                || label_count[label.vertex] == label_limit){
+            continue;
+        }
+        min_rides[label.vertex] = label.rides;
+        ++label_count[label.vertex];
+        if (label.vertex == to){
+            result_labels.push_back(label_index);
+            continue;
+        }
+
+        for (const graph::EdgeId edge_id : tc_graph_.GetIncidentEdges(label.vertex)){
+            const auto& edge = tc_graph_.GetEdge(edge_id);
+            const int rides = label.rides + (graph_edge_to_info_.at(edge_id).type == EdgeType::BUS ? 1 : 0);
+            if (rides >= min_rides[edge.to] || rides >= min_rides[to]){
+                continue;
+            }
+            labels.push_back({label.time + edge.weight, rides, edge.to, edge_id, label_index});
+            queue.push({labels.back().time + lower_bound(edge.to), rides, labels.size() - 1});
+        }
+    }
+
+    std::vector<ParetoRoute> result;
+    result.reserve(result_labels.size());
+    for (const size_t label_index : result_labels){
+        std::vector<graph::EdgeId> edges;
+        for (size_t i = label_index; labels[i].edge; i = labels[i].parent){
+            edges.push_back(*labels[i].edge);
+        }
+        std::reverse(edges.begin(), edges.end());
+        const Label& label = labels[label_index];
+        result.push_back({std::max(label.rides - 1, 0), {label.time, std::move(edges)}});
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+std::vector<RouteInfo> Router::FindAlternativeRoutes(std::string_view stop_from, std::string_view stop_to, size_t count) const{
+    const graph::VertexId from = GetStopIndex(stop_from);
+    const graph::VertexId to = GetStopIndex(stop_to);
+
+    // Shortest path tree towards the target is shared by all spur searches: removing edges
+    // only makes paths longer, so these distances stay an exact-or-lower A* heuristic
+    const AlternativesIndex& index = GetAlternativesIndex();
+    const auto to_target = graph::ComputeDistances(index.reversed_graph, to);
+    if (count == 0 || to_target[from] == graph::UNREACHABLE<double>){
+        return {};
+    }
+    const auto heuristic = [&to_target](graph::VertexId vertex){
+        return to_target[vertex];
+    };
+
+    std::vector<RouteInfo> result;
+    result.push_back(*graph::FindShortestPath(tc_graph_, from, to, heuristic, [this, &to_target, &index](graph::EdgeId edge_id){
+        return to_target[tc_graph_.GetEdge(edge_id).to] != graph::UNREACHABLE<double> && !index.is_duplicate_edge[edge_id];
+    }));
+
+    // (weight, edges, index of the first edge after the root the candidate was found from)
+    std::set<std::tuple<double, std::vector<graph::EdgeId>, size_t>> candidates;
+    std::set<std::vector<graph::EdgeId>> known_paths{result.front().edges};
+    std::vector<char> is_root_vertex(tc_graph_.GetVertexCount(), 0);
+    // Lawler's refinement of Yen's algorithm: the spur searches of a route from roots shorter than
+    // its deviation from the route it was found from were done for that route already,
+    // the best routes they can give are among the candidates or accepted
+    size_t deviation = 0;
+    while (result.size() < count){
+        const RouteInfo& previous = result.back();
+
+        // Length of the common prefix of each accepted route with the previous one
+        std::vector<size_t> common_prefix;
+        common_prefix.reserve(result.size());
+        for (const auto& route : result){
+            const auto mismatch = std::mismatch(route.edges.begin(), route.edges.end(),
+                                                previous.edges.begin(), previous.edges.end());
+            common_prefix.push_back(static_cast<size_t>(mismatch.first - route.edges.begin()));
+        }
+
+        double root_weight = 0;
+        graph::VertexId spur = from;
+        for (size_t i = 0; i < previous.edges.size(); ++i){
+            if (i >= deviation){
+                // Routes sharing the root must not continue with the same edge
+                std::vector<graph::EdgeId> blocked_edges;
+                for (size_t j = 0; j < result.size(); ++j){
+                    if (common_prefix[j] >= i && result[j].edges.size() > i){
+                        blocked_edges.push_back(result[j].edges[i]);
+                    }
+                }
+
+                auto spur_path = graph::FindShortestPath(tc_graph_, spur, to, heuristic,
+                    [this, &to_target, &index, &is_root_vertex, &blocked_edges](graph::EdgeId edge_id){
+                        const graph::VertexId next = tc_graph_.GetEdge(edge_id).to;
+                        return to_target[next] != graph::UNREACHABLE<double> && !is_root_vertex[next]
+                               && !index.is_duplicate_edge[edge_id]
+                               && std::find(blocked_edges.begin(), blocked_edges.end(), edge_id) == blocked_edges.end();
+                    });
+                if (spur_path){
+                    std::vector<graph::EdgeId> edges(previous.edges.begin(), previous.edges.begin() + i);
+                    edges.insert(edges.end(), spur_path->edges.begin(), spur_path->edges.end());
+                    if (known_paths.count(edges) == 0){
+                        candidates.insert({root_weight + spur_path->weight, std::move(edges), i});
+                    }
+                }
+            }
+
+            const auto& edge = tc_graph_.GetEdge(previous.edges[i]);
+            is_root_vertex[spur] = 1;
+            root_weight += edge.weight;
+            spur = edge.to;
+        }
+        for (const graph::EdgeId edge_id : previous.edges){
+            is_root_vertex[tc_graph_.GetEdge(edge_id).from] = 0;
+        }
+
+        // The same route may be found from different roots with a slightly different rounding
+        while (!candidates.empty() && known_paths.count(std::get<1>(*candidates.begin())) != 0){
+            candidates.erase(candidates.begin());
+        }
+        if (candidates.empty()){
+            break;
+        }
+        auto [weight, edges, spur_index] = candidates.extract(candidates.begin()).value();
+        known_paths.insert(edges);
+        result.push_back({weight, std::move(edges)});
+        deviation = spur_index;
+    }
+    return result;
 }
 
 const graph::Edge<double>& Router::GetEdge(size_t edge_id) const{
@@ -22,59 +222,151 @@ const EdgeInfo& Router::GetEdgeInfo(size_t edge_id) const{
     return graph_edge_to_info_.at(edge_id);
 }
 
+const Landmarks& Router::GetLandmarks() const{
+    return landmarks_;
+}
 
-const graph::DirectedWeightedGraph<double>& Router::ReturnInitializedGraph(){
+void Router::BuildGraph(){
     CreateGraph();
     AddStopsEdgeToGraph();
     AddStopToStopEdgeToGraph();
-    return tc_graph_;
+}
+
+const Router::AlternativesIndex& Router::GetAlternativesIndex() const{
+    std::call_once(alternatives_index_->once, [this](){
+        AlternativesIndex& index = *alternatives_index_;
+        index.reversed_graph = graph::MakeReversedGraph(tc_graph_);
+        index.is_duplicate_edge.assign(tc_graph_.GetEdgeCount(), 0);
+        std::set<std::tuple<graph::VertexId, double, std::string_view, std::optional<int>>> outgoing;
+        for (graph::VertexId vertex = 0; vertex < tc_graph_.GetVertexCount(); ++vertex){
+            outgoing.clear();
+            for (const graph::EdgeId edge_id : tc_graph_.GetIncidentEdges(vertex)){
+                const auto& edge = tc_graph_.GetEdge(edge_id);
+                const EdgeInfo& info = graph_edge_to_info_[edge_id];
+                if (!outgoing.emplace(edge.to, edge.weight, info.name, info.span_count).second){
+                    index.is_duplicate_edge[edge_id] = 1;
+                }
+            }
+        }
+    });
+    return *alternatives_index_;
+}
+
+void Router::ComputeLandmarks(){
+    // Routes always start and finish at the "waiting" vertex of a stop
+    std::vector<graph::VertexId> stop_vertices(stop_to_vertex_.begin(), stop_to_vertex_.end());
+    std::sort(stop_vertices.begin(), stop_vertices.end());
+    landmarks_ = Landmarks(tc_graph_, stop_vertices, static_cast<size_t>(std::max(settings_.landmark_count, 0)));
 }
 
 void Router::CreateGraph(){
+    // Vertices follow the order of stop names, so the graph (and the landmarks stored in the base)
+    // does not depend on the order stops were added in
+    stop_to_vertex_.resize(tc_.GetStopCount());
     size_t i = 0;
-    for (const auto& stop_name : tc_.GetAllStopNames()){
-        stopptr_to_graph_[tc_.GetStopInfo(stop_name)] = i;
+    for (const auto stop_id : tc_.GetAllStopIds()){
+        stop_to_vertex_[stop_id] = i;
         i += 2;
     }
 }
 void Router::AddStopsEdgeToGraph(){
-    for (auto stop_name : tc_.GetAllStopNames()){
-        size_t index = GetStopIndex(stop_name);
+    for (const auto stop_id : tc_.GetAllStopIds()){
+        size_t index = stop_to_vertex_[stop_id];
         auto edge_id = tc_graph_.AddEdge({index, index + 1, settings_.bus_wait_time*1.0});
-        AddEdgeInfo(edge_id, {EdgeType::WAIT, stop_name});
+        AddEdgeInfo(edge_id, {EdgeType::WAIT, tc_.GetStopName(stop_id)});
     }
 }
 
 void Router::AddStopToStopEdgeToGraph(){
-    for (auto bus_name : tc_.GetAllBusNames()){
-        auto route =  tc_.GetBusRoute(bus_name);
-        if (tc_.BusIsRoundtrip(bus_name)){
-            AddBusRouteEdgesToGraph(route.begin(), route.end(), bus_name);
-        } else {
-            auto it_middle = route.begin() + route.size() / 2;
-            AddBusRouteEdgesToGraph(route.begin(), it_middle + 1, bus_name);
-            AddBusRouteEdgesToGraph(it_middle, route.end(), bus_name);
+    const auto bus_ids = tc_.GetAllBusIds();
+    const std::vector<BusId> buses(bus_ids.begin(), bus_ids.end());
+
+    // Every bus gets its own buffer, so the result does not depend on the thread schedule
+    std::vector<std::vector<BusEdge>> bus_edges(buses.size());
+    std::atomic<size_t> next_bus = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto worker = [this, &buses, &bus_edges, &next_bus, &error, &error_mutex](){
+        try {
+            for (size_t i = next_bus++; i < buses.size(); i = next_bus++){
+                bus_edges[i] = CollectBusEdges(buses[i]);
+            }
+        } catch (...) {
+            // The other workers stop after their current bus, the error is thrown by the calling thread
+            next_bus = buses.size();
+            std::lock_guard guard(error_mutex);
+            if (!error){
+                error = std::current_exception();
+            }
         }
+    };
+    // Threads are started only when every one gets enough buses to pay for its start
+    const size_t thread_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                                                 buses.size() / MIN_BUSES_PER_THREAD);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; ++i){
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads){
+        thread.join();
+    }
+    if (error){
+        std::rethrow_exception(error);
     }
-}
 
-void Router::AddEdgeInfo(size_t edge_id, EdgeInfo edge_info){
-    graph_edge_to_info_[edge_id] = std::move(edge_info);
+    // Edge ids follow the order of bus names: offset of a bus is the prefix sum of previous buffer sizes
+    std::vector<size_t> offsets(buses.size() + 1, tc_graph_.GetEdgeCount());
+    for (size_t i = 0; i < buses.size(); ++i){
+        offsets[i + 1] = offsets[i] + bus_edges[i].size();
+    }
+    graph_edge_to_info_.resize(offsets.back());
+    for (size_t i = 0; i < buses.size(); ++i){
+        for (size_t j = 0; j < bus_edges[i].size(); ++j){
+            tc_graph_.AddEdge(bus_edges[i][j].edge);
+            graph_edge_to_info_[offsets[i] + j] = bus_edges[i][j].info;
+        }
+    }
 }
-void Router::AddStopToStopEdge(Stop* from, Stop* to, size_t edge_id){
-    pairstops_to_edge_id_[std::make_pair(from, to)] = edge_id;
+
+std::vector<Router::BusEdge> Router::CollectBusEdges(BusId bus_id) const{
+    const auto route = tc_.GetBusRoute(bus_id);
+    const auto& distances = tc_.GetBusDistances(bus_id);
+    const auto bus_name = tc_.GetBusName(bus_id);
+    std::vector<BusEdge> bus_edges;
+    if (route.IsRoundtrip()){
+        CollectBusRouteEdges(route, distances, 0, route.size(), bus_name, bus_edges);
+    } else {
+        const size_t middle = route.size() / 2;
+        CollectBusRouteEdges(route, distances, 0, middle + 1, bus_name, bus_edges);
+        CollectBusRouteEdges(route, distances, middle, route.size(), bus_name, bus_edges);
+    }
+    return bus_edges;
 }
 
-size_t Router::GetStopIndex(std::string_view stop_name) const{
-    return stopptr_to_graph_.at(tc_.GetStopInfo(stop_name));
+void Router::CollectBusRouteEdges(RouteView route, const BusDistances& distances,
+                                  size_t begin_index, size_t end_index, std::string_view bus_name,
+                                  std::vector<BusEdge>& bus_edges) const{
+    for (size_t lhs = begin_index; lhs + 1 < end_index; ++lhs){
+        const size_t from = stop_to_vertex_[route[lhs]] + 1;
+        for (size_t rhs = lhs + 1; rhs < end_index; ++rhs){
+            const double length = distances.GetRoadDistance(lhs, rhs);
+            const int span_count = static_cast<int>(rhs - lhs);
+            bus_edges.push_back({{from, stop_to_vertex_[route[rhs]], length / 1000 / settings_.bus_velocity * 60},
+                                 {EdgeType::BUS, bus_name, span_count}});
+        }
+    }
 }
-std::optional<size_t> Router::GetPairStopsEdgeId(Stop* from, Stop* to){
-     return pairstops_to_edge_id_.count(std::make_pair(from, to)) == 0 ? std::nullopt : std::optional<size_t>(pairstops_to_edge_id_.at(std::make_pair(from, to)));
+
+void Router::AddEdgeInfo(size_t edge_id, EdgeInfo edge_info){
+    if (graph_edge_to_info_.size() <= edge_id){
+        graph_edge_to_info_.resize(edge_id + 1);
+    }
+    graph_edge_to_info_[edge_id] = std::move(edge_info);
 }
 
-size_t Router::StopToStopHasher::operator() (const std::pair<Stop*, Stop*>& pairstops) const{
-    std::hash<Stop*> hasher_;
-    return static_cast<size_t>(hasher_(pairstops.first) + 1801 * hasher_(pairstops.second));
+size_t Router::GetStopIndex(std::string_view stop_name) const{
+    return stop_to_vertex_.at(tc_.FindStop(stop_name).value());
 }
 
 } // namespace router
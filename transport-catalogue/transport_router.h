@@ -1,11 +1,14 @@
 #pragma once
 
 #include "transport_catalogue.h"
-#include "router.h"
 #include "graph.h"
+#include "graph_search.h"
+#include "landmarks.h"
 
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <unordered_map>
 #include <utility>
@@ -16,69 +19,93 @@ namespace router{
 struct RoutingSettings{
     int bus_wait_time;
     double bus_velocity;
+    int landmark_count = 8;
+    int pareto_label_limit = 8;
 };
 
 struct EdgeInfo{
     EdgeType type;
+    // Stop or bus name, a view into the catalogue's string pool
     std::string_view name;
     std::optional<int> span_count = std::nullopt;
 };
 
-using RouteInfo = graph::Router<double>::RouteInfo;
+using RouteInfo = graph::Path<double>;
+using Landmarks = graph::Landmarks<double>;
 
+// One point of the (total time, transfers) Pareto frontier
+struct ParetoRoute{
+    int transfers;
+    RouteInfo route;
+};
+
+// The graph is built in the constructor (its reversed copy once, by the first FindAlternativeRoutes),
+// after that const member functions only read it,
+// so one router may answer requests from many threads at once
 class Router{
 private:
-    std::unordered_map<const Stop*, size_t> stopptr_to_graph_;
-    std::unordered_map<size_t, EdgeInfo> graph_edge_to_info_;
-
-    struct StopToStopHasher{
-        size_t operator() (const std::pair<Stop*, Stop*>& pairstops) const;
-    };
-    std::unordered_map<std::pair<Stop*, Stop*>, size_t, StopToStopHasher> pairstops_to_edge_id_;
+    // Stop with id i is waited for at vertex stop_to_vertex_[i] and boarded at the next one
+    std::vector<graph::VertexId> stop_to_vertex_;
+    std::vector<EdgeInfo> graph_edge_to_info_;
 
 public:
     Router(RoutingSettings setting, const TransportCatalogue& tc);
+    // Uses landmarks computed earlier for the same catalogue (e.g. restored from the base)
+    Router(RoutingSettings setting, const TransportCatalogue& tc, Landmarks landmarks);
+    // Shares ownership of the catalogue, so the router may outlive other references to the snapshot
+    Router(RoutingSettings setting, CatalogueSnapshot catalogue, Landmarks landmarks = {});
 
     std::optional<RouteInfo> FindRoute(std::string_view stop_from, std::string_view stop_to) const;
+    // The fastest route for every number of transfers that is not dominated by a faster route
+    // with fewer transfers. Ordered by transfers, at most pareto_label_limit routes.
+    std::vector<ParetoRoute> FindParetoRoutes(std::string_view stop_from, std::string_view stop_to) const;
+    // Up to count best loopless routes ordered by total time (Yen's algorithm)
+    std::vector<RouteInfo> FindAlternativeRoutes(std::string_view stop_from, std::string_view stop_to, size_t count) const;
 
     const graph::Edge<double>& GetEdge(size_t edge_id) const;
     const EdgeInfo& GetEdgeInfo(size_t edge_id) const;
+    const Landmarks& GetLandmarks() const;
 
 private:
     RoutingSettings settings_;
+    CatalogueSnapshot catalogue_;
     const TransportCatalogue& tc_;
     graph::DirectedWeightedGraph<double> tc_graph_;
-    graph::Router<double> router_;
+    // Needed only by FindAlternativeRoutes, so it is built by the first of them
+    struct AlternativesIndex{
+        std::once_flag once;
+        graph::DirectedWeightedGraph<double> reversed_graph;
+        // A bus passing the same stops twice gives identical parallel edges, all but the first one
+        // are skipped, otherwise they would show up as duplicate alternatives
+        std::vector<char> is_duplicate_edge;
+    };
+    std::unique_ptr<AlternativesIndex> alternatives_index_ = std::make_unique<AlternativesIndex>();
+    Landmarks landmarks_;
 
-    const graph::DirectedWeightedGraph<double>& ReturnInitializedGraph();
+    void BuildGraph();
+    void ComputeLandmarks();
     void CreateGraph();
     void AddStopsEdgeToGraph();
     void AddStopToStopEdgeToGraph();
-    template <typename InputIt>
-    void AddBusRouteEdgesToGraph(InputIt begin_range, InputIt end_range, std::string_view bus_name);
+
+    struct BusEdge{
+        graph::Edge<double> edge;
+        EdgeInfo info;
+    };
+    // Only reads the catalogue and the stop indexes, so buses are processed concurrently
+    std::vector<BusEdge> CollectBusEdges(BusId bus_id) const;
+    // Edges between every pair of stops of the route part [begin_index, end_index)
+    void CollectBusRouteEdges(RouteView route, const BusDistances& distances,
+                              size_t begin_index, size_t end_index, std::string_view bus_name,
+                              std::vector<BusEdge>& bus_edges) const;
 
     void AddEdgeInfo(size_t edge_id, EdgeInfo edge_info);
-    void AddStopToStopEdge(Stop* from, Stop* to, size_t edge_id);
+
+    const AlternativesIndex& GetAlternativesIndex() const;
 
     size_t GetStopIndex(std::string_view stop_name) const;
-    std::optional<size_t> GetPairStopsEdgeId(Stop* from, Stop* to);
 };
 
-template <typename InputIt>
-void Router::AddBusRouteEdgesToGraph(InputIt begin_range, InputIt end_range, std::string_view bus_name){
-    for (auto it_lhs = begin_range; it_lhs != end_range - 1; ++it_lhs){
-        double length = 0;
-        int span_count = 1;
-        auto it_prev_rhs = it_lhs;
-        for (auto it_rhs = it_lhs + 1; it_rhs != end_range; it_prev_rhs = it_rhs, ++it_rhs, ++span_count){
-            length += tc_.GetDistance(*it_prev_rhs, *it_rhs);
-            auto edge_id = tc_graph_.AddEdge({GetStopIndex((*it_lhs)->name) + 1, GetStopIndex((*it_rhs)->name), length / 1000 / settings_.bus_velocity * 60});
-            AddEdgeInfo(edge_id, {EdgeType::BUS, bus_name, span_count});
-            AddStopToStopEdge(*it_lhs, *it_rhs ,edge_id);
-        }
-    }
-}
-
 } // namespace router
 } // namespace tc
 